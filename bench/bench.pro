@@ -0,0 +1,3 @@
+TEMPLATE = subdirs
+
+SUBDIRS += spawn throughput latency lifecycle soak training scanner
@@ -0,0 +1,26 @@
+# Application sources for benchmarks that need real terminal widgets
+
+QT += gui gui-private widgets network
+CONFIG += c++11 console link_pkgconfig
+CONFIG -= app_bundle
+PKGCONFIG += qtermwidget5 x11
+
+DEFINES += STR_VERSION=\\\"1.0\\\"
+
+include(../pgo.pri)
+
+SOURCE_DIR = $$PWD/../src
+
+HEADERS += $$files($$SOURCE_DIR/3rdparty/*.h)
+SOURCES += $$files($$SOURCE_DIR/3rdparty/*.cpp)
+
+HEADERS += $$files($$SOURCE_DIR/*.h)
+SOURCES += $$files($$SOURCE_DIR/*.cpp)
+SOURCES -= $$SOURCE_DIR/main.cpp
+
+INCLUDEPATH += $$SOURCE_DIR $$SOURCE_DIR/3rdparty
+
+RESOURCES += $$SOURCE_DIR/icons.qrc
+FORMS += $$files($$SOURCE_DIR/forms/*.ui)
+
+LIBS += -lutil
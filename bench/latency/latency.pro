@@ -0,0 +1,5 @@
+include(../common.pri)
+
+TARGET = latencybench
+
+SOURCES += main.cpp
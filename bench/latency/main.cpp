@@ -0,0 +1,171 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+// Types into a terminal running cat and measures the time from each key
+// press to the paint that shows its echo, first with no other output, then
+// while another terminal is flooded with output. Runs under the offscreen
+// platform unless QT_QPA_PLATFORM is set.
+//
+// Exits with a non-zero status when any keystroke was not echoed.
+//
+// Usage: latencybench [keystrokes]
+
+#include "inputlatency.h"
+#include "outputscanner.h"
+#include "spawnhelper.h"
+#include "terminalwidget.h"
+
+#include <QApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QKeyEvent>
+#include <QTimer>
+
+#include <stdio.h>
+
+namespace {
+const int DefaultKeystrokes = 500;
+const int KeyTimeout = 2000; // ms
+const int TypingInterval = 20; // ms
+const int LineLength = 60;
+
+void processEvents(int duration)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < duration)
+        QCoreApplication::processEvents(QEventLoop::AllEvents, duration - timer.elapsed());
+}
+
+QWidget *terminalDisplay(TerminalWidget *terminal)
+{
+    foreach (QWidget *child, terminal->findChildren<QWidget *>()) {
+        if (child->inherits("Konsole::TerminalDisplay"))
+            return child;
+    }
+    return nullptr;
+}
+
+void type(QWidget *display, Qt::Key key, const QString &text)
+{
+    QKeyEvent press(QEvent::KeyPress, key, Qt::NoModifier, text);
+    QCoreApplication::sendEvent(display, &press);
+    QKeyEvent release(QEvent::KeyRelease, key, Qt::NoModifier, text);
+    QCoreApplication::sendEvent(display, &release);
+}
+
+QJsonObject run(TerminalWidget *terminal, int keystrokes, bool busy)
+{
+    QWidget *display = terminalDisplay(terminal);
+    if (!display)
+        qFatal("Cannot find the terminal display");
+
+    InputLatency::clear();
+    int timeouts = 0;
+
+    // Wakes up the event loop, so that a lost echo times out
+    QTimer wakeUpTimer;
+    wakeUpTimer.start(KeyTimeout / 10);
+
+    for (int i = 0; i < keystrokes; ++i) {
+        const int count = InputLatency::sampleCount();
+        const QChar character('a' + i % 26);
+        type(display, static_cast<Qt::Key>(Qt::Key_A + i % 26), character);
+
+        QElapsedTimer timer;
+        timer.start();
+        while (InputLatency::sampleCount() == count && timer.elapsed() < KeyTimeout)
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+        if (InputLatency::sampleCount() == count)
+            ++timeouts;
+
+        // Keep the line short, cat echoes it again on return
+        if (i % LineLength == LineLength - 1) {
+            type(display, Qt::Key_Return, QStringLiteral("\r"));
+            processEvents(TypingInterval);
+        }
+        processEvents(TypingInterval);
+    }
+
+    const InputLatency::Summary summary = InputLatency::summary(busy);
+
+    QJsonObject result;
+    result.insert(QStringLiteral("samples"), summary.count);
+    result.insert(QStringLiteral("timeouts"), timeouts);
+    result.insert(QStringLiteral("p50Ms"), summary.p50 / 1000.0);
+    result.insert(QStringLiteral("p99Ms"), summary.p99 / 1000.0);
+    result.insert(QStringLiteral("maxMs"), summary.max / 1000.0);
+    return result;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    OutputScanner::initialize();
+    if (!SpawnHelper::start())
+        qFatal("Cannot start the spawn helper");
+
+    QApplication app(argc, argv);
+    // Use default preferences rather than those of the user
+    app.setOrganizationName(QStringLiteral("QuickTerminalBench"));
+    app.setApplicationName(QStringLiteral("latencybench"));
+
+    const QStringList args = app.arguments();
+    const int keystrokes = args.size() > 1 ? args.at(1).toInt() : DefaultKeystrokes;
+
+    InputLatency::setEnabled(true);
+
+    TerminalWidget terminal(QDir::currentPath(), QStringLiteral("cat"));
+    terminal.resize(800, 600);
+    terminal.show();
+    processEvents(500);
+
+    QJsonObject results;
+    const QJsonObject idle = run(&terminal, keystrokes, false);
+    results.insert(QStringLiteral("idle"), idle);
+
+    TerminalWidget flood(QDir::currentPath(), QStringLiteral("yes"));
+    flood.resize(800, 600);
+    flood.show();
+    processEvents(500);
+
+    const QJsonObject busy = run(&terminal, keystrokes, true);
+    results.insert(QStringLiteral("busy"), busy);
+
+    QFile out;
+    out.open(stdout, QIODevice::WriteOnly);
+    out.write(QJsonDocument(results).toJson());
+
+    SpawnHelper::stop();
+
+    // A lost echo means typed input did not reach the process, the numbers are meaningless
+    const int timeouts = idle.value(QStringLiteral("timeouts")).toInt()
+            + busy.value(QStringLiteral("timeouts")).toInt();
+    if (timeouts) {
+        fprintf(stderr, "%d keystrokes were not echoed\n", timeouts);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,7 @@
+include(../common.pri)
+
+QT += testlib
+
+TARGET = lifecyclebench
+
+SOURCES += main.cpp
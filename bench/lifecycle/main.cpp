@@ -0,0 +1,368 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+// Benchmarks for tab, split and window lifecycle operations at scale.
+// Terminals are created without starting a process, so the numbers cover
+// the widgets only. A single check starts cat and verifies that keys typed
+// into the terminal reach it. Runs under the offscreen platform unless
+// QT_QPA_PLATFORM is set.
+//
+// Usage: lifecyclebench [QtTest options]
+
+#include "actionmanager.h"
+#include "application.h"
+#include "mainwindow.h"
+#include "outputscanner.h"
+#include "preferences.h"
+#include "spawnhelper.h"
+#include "tabwidget.h"
+#include "termwidgetholder.h"
+
+#include <QDir>
+#include <QFile>
+#include <QKeyEvent>
+#include <QSplitter>
+#include <QtTest>
+
+#include <malloc.h>
+#include <unistd.h>
+
+namespace {
+qint64 residentSetSize()
+{
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (!statm.open(QIODevice::ReadOnly))
+        return 0;
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    return fields.size() > 1 ? fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE) : 0;
+}
+
+void deletePendingObjects()
+{
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+}
+
+/// Splits the newest terminal \a depth times, nesting a splitter each time
+TerminalWidget *splitDeep(TermWidgetHolder *holder, int depth)
+{
+    for (int i = 0; i < depth; ++i) {
+        if (i % 2)
+            holder->splitHorizontal(holder->terminals().last());
+        else
+            holder->splitVertical(holder->terminals().last());
+    }
+    return holder->terminals().last();
+}
+
+/// Number of splitters between \a widget and its holder
+int splitterDepth(QWidget *widget)
+{
+    int depth = 0;
+    for (QWidget *parent = widget->parentWidget(); qobject_cast<QSplitter *>(parent);
+         parent = parent->parentWidget()) {
+        ++depth;
+    }
+    return depth;
+}
+
+void type(QWidget *display, Qt::Key key, const QString &text)
+{
+    QKeyEvent press(QEvent::KeyPress, key, Qt::NoModifier, text);
+    QCoreApplication::sendEvent(display, &press);
+    QKeyEvent release(QEvent::KeyRelease, key, Qt::NoModifier, text);
+    QCoreApplication::sendEvent(display, &release);
+}
+}
+
+class LifecycleBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void cleanup();
+
+    void addNewTab_data();
+    void addNewTab();
+    void removeTab_data();
+    void removeTab();
+
+    void splitCollapse_data();
+    void splitCollapse();
+    void switchNextSubterminal_data();
+    void switchNextSubterminal();
+    void gridIsFlat();
+
+    void mainWindowConstruction();
+    void windowCreatesNoActions();
+    void shortcutReachesActiveWindow();
+
+    void preferencesLoad();
+    void preferencesSave();
+
+    void terminalMemory();
+
+    void typedInputReachesShell();
+};
+
+void LifecycleBenchmark::initTestCase()
+{
+    // Use default preferences rather than those of the user
+    QCoreApplication::setOrganizationName(QStringLiteral("QuickTerminalBench"));
+    QCoreApplication::setApplicationName(QStringLiteral("lifecyclebench"));
+
+    Preferences::instance()->shellPoolSize = 0;
+    TerminalWidget::setStartDeferred(true);
+
+    // Windows cost what they do after startup, with all actions and shortcuts registered
+    Application::setupActions();
+}
+
+void LifecycleBenchmark::cleanupTestCase()
+{
+    TerminalWidget::setStartDeferred(false);
+}
+
+void LifecycleBenchmark::cleanup()
+{
+    // Drops the pending starts of the terminals deleted by the finished case
+    TerminalWidget::setStartDeferred(false);
+    TerminalWidget::setStartDeferred(true);
+}
+
+void LifecycleBenchmark::addNewTab_data()
+{
+    QTest::addColumn<int>("tabs");
+    QTest::newRow("10") << 10;
+    QTest::newRow("100") << 100;
+    QTest::newRow("500") << 500;
+}
+
+void LifecycleBenchmark::addNewTab()
+{
+    QFETCH(int, tabs);
+
+    TabWidget tabWidget;
+    tabWidget.setWorkDirectory(QDir::currentPath());
+    for (int i = 1; i < tabs; ++i)
+        tabWidget.addNewTab();
+
+    // Adds the last tab, then restores the initial state
+    QBENCHMARK {
+        tabWidget.addNewTab();
+        QTabWidget *base = &tabWidget;
+        QWidget *holder = base->widget(base->count() - 1);
+        base->removeTab(base->count() - 1);
+        delete holder;
+    }
+}
+
+void LifecycleBenchmark::removeTab_data()
+{
+    addNewTab_data();
+}
+
+void LifecycleBenchmark::removeTab()
+{
+    QFETCH(int, tabs);
+
+    TabWidget tabWidget;
+    tabWidget.setWorkDirectory(QDir::currentPath());
+    for (int i = 0; i < tabs; ++i)
+        tabWidget.addNewTab();
+
+    // Removes the first tab, which renumbers all others, then adds one back
+    QBENCHMARK {
+        tabWidget.removeTab(0);
+        deletePendingObjects();
+        tabWidget.QTabWidget::addTab(new TermWidgetHolder(QDir::currentPath()), QString());
+    }
+}
+
+void LifecycleBenchmark::splitCollapse_data()
+{
+    QTest::addColumn<int>("depth");
+    QTest::newRow("1") << 1;
+    QTest::newRow("8") << 8;
+    QTest::newRow("32") << 32;
+}
+
+void LifecycleBenchmark::splitCollapse()
+{
+    QFETCH(int, depth);
+
+    TermWidgetHolder holder(QDir::currentPath());
+    TerminalWidget *terminal = splitDeep(&holder, depth - 1);
+
+    QBENCHMARK {
+        holder.splitVertical(terminal);
+        holder.splitCollapse(holder.terminals().last());
+    }
+}
+
+void LifecycleBenchmark::switchNextSubterminal_data()
+{
+    splitCollapse_data();
+}
+
+void LifecycleBenchmark::switchNextSubterminal()
+{
+    QFETCH(int, depth);
+
+    TermWidgetHolder holder(QDir::currentPath());
+    splitDeep(&holder, depth);
+    holder.show();
+    holder.activateWindow();
+    QVERIFY(QTest::qWaitForWindowActive(&holder));
+
+    QBENCHMARK {
+        holder.switchNextSubterminal();
+    }
+}
+
+void LifecycleBenchmark::gridIsFlat()
+{
+    TermWidgetHolder holder(QDir::currentPath());
+    holder.createGrid(holder.terminals().first(), 3, 4);
+
+    // The root splitter holds the rows, each row holds its terminals
+    QCOMPARE(holder.terminals().size(), 12);
+    foreach (TerminalWidget *terminal, holder.terminals())
+        QCOMPARE(splitterDepth(terminal), 2);
+}
+
+void LifecycleBenchmark::mainWindowConstruction()
+{
+    // A window with one tab and its menus; Application::openWindow() also connects and shows it
+    QBENCHMARK {
+        MainWindow *window = new MainWindow(QDir::currentPath(), QString());
+        window->setupMenus();
+        delete window;
+    }
+}
+
+void LifecycleBenchmark::windowCreatesNoActions()
+{
+    MainWindow window(QDir::currentPath(), QString());
+    window.setupMenus();
+
+    // Shortcuts are shared, actions of a window are created when its menus are opened
+    ActionManager *actionManager = window.findChild<ActionManager *>();
+    QVERIFY(actionManager);
+    QCOMPARE(actionManager->findChildren<QAction *>().size(), 0);
+}
+
+void LifecycleBenchmark::shortcutReachesActiveWindow()
+{
+    MainWindow first(QDir::currentPath(), QString());
+    first.setupMenus();
+    first.show();
+    MainWindow second(QDir::currentPath(), QString());
+    second.setupMenus();
+    second.show();
+    second.activateWindow();
+    QVERIFY(QTest::qWaitForWindowActive(&second));
+
+    const int firstTabs = first.tabWidget()->count();
+    const int secondTabs = second.tabWidget()->count();
+    QTest::keyClick(&second, Qt::Key_T, Qt::ControlModifier | Qt::ShiftModifier);
+
+    QCOMPARE(second.tabWidget()->count(), secondTabs + 1);
+    QCOMPARE(first.tabWidget()->count(), firstTabs);
+}
+
+void LifecycleBenchmark::preferencesLoad()
+{
+    Preferences *preferences = Preferences::instance();
+    QBENCHMARK {
+        preferences->load();
+    }
+}
+
+void LifecycleBenchmark::preferencesSave()
+{
+    Preferences *preferences = Preferences::instance();
+    QBENCHMARK {
+        preferences->save();
+    }
+}
+
+void LifecycleBenchmark::terminalMemory()
+{
+    const int count = 50;
+
+    QWidget parent;
+    QList<TerminalWidget *> terminals;
+
+    // The first terminal pays for fonts, color schemes and key bindings
+    terminals.append(new TerminalWidget(QDir::currentPath(), QString(), &parent));
+
+    malloc_trim(0);
+    const qint64 before = residentSetSize();
+    for (int i = 0; i < count; ++i)
+        terminals.append(new TerminalWidget(QDir::currentPath(), QString(), &parent));
+    const qint64 after = residentSetSize();
+
+    QTest::setBenchmarkResult((after - before) / count, QTest::BytesAllocated);
+}
+
+void LifecycleBenchmark::typedInputReachesShell()
+{
+    TerminalWidget terminal(QDir::currentPath(), QStringLiteral("cat"));
+    terminal.resize(800, 600);
+    terminal.show();
+    terminal.start();
+    QVERIFY(QTest::qWaitForWindowExposed(&terminal));
+
+    QWidget *display = nullptr;
+    foreach (QWidget *child, terminal.findChildren<QWidget *>()) {
+        if (child->inherits("Konsole::TerminalDisplay"))
+            display = child;
+    }
+    QVERIFY(display);
+
+    // The PTY echoes the line and cat prints it again, both come back as output
+    const quint64 before = terminal.bytesReceived();
+    const QString text = QStringLiteral("hello");
+    for (const QChar &character : text)
+        type(display, static_cast<Qt::Key>(Qt::Key_A + character.unicode() - 'a'), character);
+    type(display, Qt::Key_Return, QStringLiteral("\r"));
+
+    QTRY_VERIFY(terminal.bytesReceived() >= before + 2 * (text.size() + 2));
+}
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    OutputScanner::initialize();
+    if (!SpawnHelper::start())
+        qFatal("Cannot start the spawn helper");
+
+    QApplication app(argc, argv);
+    LifecycleBenchmark benchmark;
+    const int result = QTest::qExec(&benchmark, argc, argv);
+
+    SpawnHelper::stop();
+    return result;
+}
+
+#include "main.moc"
@@ -0,0 +1,200 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+// Measures the output scanner kernels of every implementation the CPU
+// supports on typical terminal output.
+//
+// Usage: scannerbench [MiB per workload]
+
+#include "outputscanner.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+
+namespace {
+const int DefaultWorkloadSize = 64; // MiB
+const int ChunkSize = 64 * 1024;
+const int MinimumTime = 200; // ms
+
+char printable(int i)
+{
+    return '!' + i % 94;
+}
+
+QByteArray asciiWorkload(int size)
+{
+    QByteArray data;
+    data.reserve(size + 128);
+    for (int line = 0; data.size() < size; ++line) {
+        for (int i = 0; i < 79; ++i)
+            data += printable(line + i);
+        data += "\r\n";
+    }
+    return data;
+}
+
+QByteArray sgrWorkload(int size)
+{
+    QByteArray data;
+    data.reserve(size + 1024);
+    for (int line = 0; data.size() < size; ++line) {
+        for (int i = 0; i < 79; i += 8) {
+            data += "\033[38;5;" + QByteArray::number((line + i) % 256) + 'm';
+            for (int j = 0; j < 8; ++j)
+                data += printable(line + i + j);
+        }
+        data += "\033[0m\r\n";
+    }
+    return data;
+}
+
+QByteArray unicodeWorkload(int size)
+{
+    const QByteArray words = QStringLiteral("漢字 ひらがな 한국어 Größe ΑΒΓΔ →✓€ ").toUtf8();
+
+    QByteArray data;
+    data.reserve(size + 1024);
+    for (int line = 0; data.size() < size; ++line)
+        data += words + words + "\r\n";
+    return data;
+}
+
+// Walks all control characters like a parser looking for the next sequence
+int scanControls(const QByteArray &data)
+{
+    int controls = 0;
+    for (int offset = 0; offset < data.size(); offset += ChunkSize) {
+        const char *chunk = data.constData() + offset;
+        const int length = qMin(ChunkSize, data.size() - offset);
+        for (int i = OutputScanner::findControl(chunk, length); i < length;
+             i += 1 + OutputScanner::findControl(chunk + i + 1, length - i - 1)) {
+            ++controls;
+        }
+    }
+    return controls;
+}
+
+int countLines(const QByteArray &data)
+{
+    int lines = 0;
+    for (int offset = 0; offset < data.size(); offset += ChunkSize)
+        lines += OutputScanner::countLines(data.constData() + offset,
+                                           qMin(ChunkSize, data.size() - offset));
+    return lines;
+}
+
+int chunkBoundaries(const QByteArray &data)
+{
+    int trimmed = 0;
+    for (int offset = 0; offset + ChunkSize < data.size(); offset += ChunkSize)
+        trimmed += ChunkSize - OutputScanner::chunkBoundary(data.constData() + offset, ChunkSize);
+    return trimmed;
+}
+
+/// Calls chunkBoundaries() makes, it only looks at the end of each chunk
+int chunkBoundaryCalls(const QByteArray &data)
+{
+    return qMax(0, (data.size() - 1) / ChunkSize);
+}
+
+/// Runs \a kernel until enough time has passed and returns the seconds per run
+double measure(int (*kernel)(const QByteArray &), const QByteArray &data, int *result)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    int runs = 0;
+    do {
+        *result = kernel(data);
+        ++runs;
+    } while (timer.elapsed() < MinimumTime);
+
+    return timer.nsecsElapsed() / 1e9 / runs;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    const QStringList args = app.arguments();
+    const int size = (args.size() > 1 ? args.at(1).toInt() : DefaultWorkloadSize) * 1024 * 1024;
+
+    const struct {
+        const char *name;
+        QByteArray data;
+    } workloads[] = {
+        { "ascii", asciiWorkload(size) },
+        { "sgr", sgrWorkload(size) },
+        { "unicode", unicodeWorkload(size) }
+    };
+
+    // Kernels that scan whole chunks report throughput, the others time per call
+    const struct {
+        const char *name;
+        int (*run)(const QByteArray &);
+        int (*calls)(const QByteArray &);
+    } kernels[] = {
+        { "findControl", scanControls, nullptr },
+        { "countLines", countLines, nullptr },
+        { "chunkBoundary", chunkBoundaries, chunkBoundaryCalls }
+    };
+
+    QJsonArray results;
+    for (int i = 0; i < OutputScanner::ImplementationCount; ++i) {
+        const OutputScanner::Implementation implementation
+                = static_cast<OutputScanner::Implementation>(i);
+        if (!OutputScanner::setImplementation(implementation))
+            continue;
+
+        for (const auto &workload : workloads) {
+            for (const auto &kernel : kernels) {
+                int result = 0;
+                const double seconds = measure(kernel.run, workload.data, &result);
+
+                QJsonObject object;
+                object.insert(QStringLiteral("implementation"),
+                              QString::fromLatin1(OutputScanner::implementationName(implementation)));
+                object.insert(QStringLiteral("workload"), QString::fromLatin1(workload.name));
+                object.insert(QStringLiteral("kernel"), QString::fromLatin1(kernel.name));
+                if (kernel.calls) {
+                    object.insert(QStringLiteral("nsPerCall"),
+                                  seconds * 1e9 / qMax(1, kernel.calls(workload.data)));
+                } else {
+                    object.insert(QStringLiteral("mbPerSecond"),
+                                  workload.data.size() / seconds / (1024 * 1024));
+                }
+                object.insert(QStringLiteral("result"), result);
+                results.append(object);
+            }
+        }
+    }
+
+    QFile out;
+    out.open(stdout, QIODevice::WriteOnly);
+    out.write(QJsonDocument(results).toJson());
+
+    return 0;
+}
@@ -0,0 +1,5 @@
+include(../common.pri)
+
+TARGET = scannerbench
+
+SOURCES += main.cpp
@@ -0,0 +1,276 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+// Soak test: opens and closes tabs, splits and collapses terminals, changes
+// preferences and streams output for a long time, sampling memory use and
+// the number of live widgets. Fails if RSS grows beyond a tolerance after the
+// warm-up, or if widgets are left behind once everything has been closed.
+// Runs under the offscreen platform unless QT_QPA_PLATFORM is set.
+//
+// Usage: soakbench [minutes] [tolerance in MiB] [seed]
+
+#include "mainwindow.h"
+#include "outputscanner.h"
+#include "preferences.h"
+#include "spawnhelper.h"
+#include "tabwidget.h"
+#include "termwidgetholder.h"
+
+#include <QApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSplitter>
+#include <QTimer>
+
+#include <malloc.h>
+#include <unistd.h>
+
+namespace {
+const int DefaultDuration = 60; // min
+const int DefaultTolerance = 64; // MiB
+const int StepInterval = 50; // ms
+const int SampleInterval = 10000; // ms
+const int SettleTime = 1000; // ms
+const int MaxTabs = 16;
+const int MaxTerminalsPerTab = 8;
+
+// Commands run in new tabs, an empty one starts the shell
+const char * const Commands[] = { "", "", "yes", "top -b -d 0.2" };
+
+qint64 residentSetSize()
+{
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (!statm.open(QIODevice::ReadOnly))
+        return 0;
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    return fields.size() > 1 ? fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE) : 0;
+}
+
+qint64 heapInUse()
+{
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+    return mallinfo2().uordblks;
+#else
+    return mallinfo().uordblks;
+#endif
+}
+
+struct Sample {
+    qint64 elapsed = 0; // s
+    qint64 rss = 0;
+    qint64 heap = 0;
+    int terminals = 0;
+    int splitters = 0;
+    int holders = 0;
+
+    QJsonObject toJson() const
+    {
+        QJsonObject object;
+        object.insert(QStringLiteral("seconds"), elapsed);
+        object.insert(QStringLiteral("rssMiB"), rss / (1024.0 * 1024.0));
+        object.insert(QStringLiteral("heapMiB"), heap / (1024.0 * 1024.0));
+        object.insert(QStringLiteral("terminals"), terminals);
+        object.insert(QStringLiteral("splitters"), splitters);
+        object.insert(QStringLiteral("holders"), holders);
+        return object;
+    }
+};
+
+Sample takeSample(const QElapsedTimer &clock)
+{
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+
+    Sample sample;
+    sample.elapsed = clock.elapsed() / 1000;
+    sample.rss = residentSetSize();
+    sample.heap = heapInUse();
+
+    // All widgets, including any that were unparented and never deleted
+    foreach (QWidget *widget, QApplication::allWidgets()) {
+        if (qobject_cast<TerminalWidget *>(widget))
+            ++sample.terminals;
+        else if (qobject_cast<TermWidgetHolder *>(widget))
+            ++sample.holders;
+        else if (qobject_cast<QSplitter *>(widget))
+            ++sample.splitters;
+    }
+    return sample;
+}
+
+void print(const QJsonObject &object)
+{
+    QFile out;
+    out.open(stdout, QIODevice::WriteOnly);
+    out.write(QJsonDocument(object).toJson(QJsonDocument::Compact) + '\n');
+}
+
+void changePreferences()
+{
+    Preferences *preferences = Preferences::instance();
+    switch (qrand() % 3) {
+    case 0:
+        preferences->historyLimited = !preferences->historyLimited;
+        break;
+    case 1:
+        preferences->terminalOpacity = 50 + qrand() % 51;
+        break;
+    case 2:
+        preferences->scrollBarPosition = qrand() % 3;
+        break;
+    }
+    preferences->emitChanged();
+}
+
+void step(TabWidget *tabWidget)
+{
+    TermWidgetHolder *holder = tabWidget->terminalHolder();
+    const int terminals = holder ? holder->terminals().size() : 0;
+
+    switch (qrand() % 8) {
+    case 0:
+    case 1:
+        if (tabWidget->count() < MaxTabs) {
+            const int command = qrand() % (sizeof(Commands) / sizeof(Commands[0]));
+            tabWidget->addNewTab(QString::fromLatin1(Commands[command]));
+        }
+        break;
+    case 2:
+        if (tabWidget->count() > 1)
+            tabWidget->removeTab(qrand() % tabWidget->count());
+        break;
+    case 3:
+        if (holder && terminals < MaxTerminalsPerTab)
+            tabWidget->splitHorizontally();
+        break;
+    case 4:
+        if (holder && terminals < MaxTerminalsPerTab)
+            tabWidget->splitVertically();
+        break;
+    case 5:
+        if (holder && terminals > 1)
+            tabWidget->splitCollapse();
+        break;
+    case 6:
+        tabWidget->setCurrentIndex(qrand() % tabWidget->count());
+        break;
+    case 7:
+        changePreferences();
+        break;
+    }
+}
+
+/// Closes everything but the first terminal of the first tab
+void reset(TabWidget *tabWidget)
+{
+    while (tabWidget->count() > 1)
+        tabWidget->removeTab(tabWidget->count() - 1);
+
+    tabWidget->setCurrentIndex(0);
+    while (tabWidget->terminalHolder()->terminals().size() > 1)
+        tabWidget->splitCollapse();
+
+    // Let deferred deletes and the shell pool settle
+    QEventLoop loop;
+    QTimer::singleShot(SettleTime, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+}
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    OutputScanner::initialize();
+    if (!SpawnHelper::start())
+        qFatal("Cannot start the spawn helper");
+
+    QApplication app(argc, argv);
+    // Use default preferences rather than those of the user
+    app.setOrganizationName(QStringLiteral("QuickTerminalBench"));
+    app.setApplicationName(QStringLiteral("soakbench"));
+
+    const QStringList args = app.arguments();
+    const int duration = (args.size() > 1 ? args.at(1).toInt() : DefaultDuration) * 60 * 1000;
+    const qint64 tolerance
+            = qint64(args.size() > 2 ? args.at(2).toInt() : DefaultTolerance) * 1024 * 1024;
+    qsrand(args.size() > 3 ? args.at(3).toUInt() : 1);
+
+    MainWindow window(QDir::currentPath(), QString());
+    window.show();
+    TabWidget *tabWidget = window.tabWidget();
+
+    QElapsedTimer clock;
+    clock.start();
+
+    // Baselines are taken once caches and pools have filled up
+    const int warmUp = qMin(5 * 60 * 1000, duration / 10);
+    bool warm = false;
+    Sample baseline;
+
+    QTimer stepTimer;
+    QObject::connect(&stepTimer, &QTimer::timeout, [tabWidget]() {
+        step(tabWidget);
+    });
+
+    QTimer sampleTimer;
+    QObject::connect(&sampleTimer, &QTimer::timeout, [&]() {
+        if (!warm && clock.elapsed() >= warmUp) {
+            warm = true;
+            reset(tabWidget);
+            baseline = takeSample(clock);
+        }
+        print(takeSample(clock).toJson());
+    });
+
+    QTimer::singleShot(duration, &app, &QCoreApplication::quit);
+
+    stepTimer.start(StepInterval);
+    sampleTimer.start(SampleInterval);
+    app.exec();
+
+    stepTimer.stop();
+    sampleTimer.stop();
+
+    // With everything closed again, the process must be back to its baseline
+    reset(tabWidget);
+    const Sample last = takeSample(clock);
+
+    const qint64 growth = last.rss - baseline.rss;
+    const bool leakedWidgets = last.terminals != baseline.terminals
+            || last.splitters != baseline.splitters
+            || last.holders != baseline.holders;
+    const bool passed = warm && growth <= tolerance && !leakedWidgets;
+
+    QJsonObject result;
+    result.insert(QStringLiteral("baseline"), baseline.toJson());
+    result.insert(QStringLiteral("final"), last.toJson());
+    result.insert(QStringLiteral("rssGrowthMiB"), growth / (1024.0 * 1024.0));
+    result.insert(QStringLiteral("toleranceMiB"), tolerance / (1024.0 * 1024.0));
+    result.insert(QStringLiteral("leakedWidgets"), leakedWidgets);
+    result.insert(QStringLiteral("passed"), passed);
+    print(result);
+
+    SpawnHelper::stop();
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,5 @@
+include(../common.pri)
+
+TARGET = soakbench
+
+SOURCES += main.cpp
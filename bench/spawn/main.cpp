@@ -0,0 +1,155 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+// Measures how long it takes to spawn a process on a new PTY, forking either
+// from this process or from the spawn helper, while this process grows.
+//
+// Usage: spawnbench [iterations] [rss in MiB]...
+
+#include "spawnhelper.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcessEnvironment>
+
+#include <algorithm>
+
+#include <errno.h>
+#include <pty.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+const char Program[] = "/bin/true";
+
+qint64 residentSetSize()
+{
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (!statm.open(QIODevice::ReadOnly))
+        return 0;
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    return fields.size() > 1 ? fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE) : 0;
+}
+
+/// Waits until the process on the other side of the PTY has exited
+void waitForExit(int masterFd)
+{
+    char buffer[256];
+    for (;;) {
+        const ssize_t size = read(masterFd, buffer, sizeof(buffer));
+        if (size > 0 || (size < 0 && errno == EINTR))
+            continue;
+        break;
+    }
+    close(masterFd);
+}
+
+qint64 spawnDirect()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    int masterFd;
+    const pid_t pid = forkpty(&masterFd, nullptr, nullptr, nullptr);
+    if (pid == 0) {
+        execl(Program, Program, static_cast<char *>(nullptr));
+        _exit(127);
+    }
+    if (pid < 0)
+        qFatal("forkpty failed: %s", strerror(errno));
+
+    waitForExit(masterFd);
+    waitpid(pid, nullptr, 0);
+    return timer.nsecsElapsed();
+}
+
+qint64 spawnHelper(const QStringList &environment)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const SpawnHelper::Process process
+            = SpawnHelper::spawn(QString::fromLatin1(Program), QStringList(),
+                                 QStringLiteral("/"), environment);
+    if (process.masterFd < 0)
+        qFatal("Spawn helper failed");
+
+    waitForExit(process.masterFd);
+    return timer.nsecsElapsed();
+}
+
+double median(QVector<qint64> samples)
+{
+    std::sort(samples.begin(), samples.end());
+    return samples.at(samples.size() / 2) / 1e6;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    if (!SpawnHelper::start())
+        qFatal("Cannot start the spawn helper");
+
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+    args.removeFirst();
+
+    const int iterations = args.isEmpty() ? 50 : args.takeFirst().toInt();
+    QList<int> sizes;
+    foreach (const QString &arg, args)
+        sizes.append(arg.toInt());
+    if (sizes.isEmpty())
+        sizes << 0 << 256 << 1024 << 4096;
+
+    const QStringList environment = QProcessEnvironment::systemEnvironment().toStringList();
+
+    QList<QByteArray> ballast;
+    QJsonArray results;
+
+    foreach (int size, sizes) {
+        // Grow the process and touch every page, so that fork has to copy the page tables
+        while (residentSetSize() < qint64(size) * 1024 * 1024)
+            ballast.append(QByteArray(64 * 1024 * 1024, 'x'));
+
+        QVector<qint64> direct;
+        QVector<qint64> helper;
+        for (int i = 0; i < iterations; ++i) {
+            direct.append(spawnDirect());
+            helper.append(spawnHelper(environment));
+        }
+
+        QJsonObject result;
+        result.insert(QStringLiteral("rssMiB"), residentSetSize() / (1024 * 1024));
+        result.insert(QStringLiteral("directMs"), median(direct));
+        result.insert(QStringLiteral("helperMs"), median(helper));
+        results.append(result);
+    }
+
+    QFile out;
+    out.open(stdout, QIODevice::WriteOnly);
+    out.write(QJsonDocument(results).toJson());
+
+    SpawnHelper::stop();
+    return 0;
+}
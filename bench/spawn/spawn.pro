@@ -0,0 +1,12 @@
+QT -= gui
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = spawnbench
+
+INCLUDEPATH += ../../src
+
+HEADERS += ../../src/spawnhelper.h
+SOURCES += ../../src/spawnhelper.cpp main.cpp
+
+LIBS += -lutil
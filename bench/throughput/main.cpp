@@ -0,0 +1,298 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+// Feeds standard workloads to a terminal widget and measures how fast it
+// consumes them. Runs under the offscreen platform unless QT_QPA_PLATFORM is
+// set, so it works on machines without a display.
+//
+// Usage: throughputbench [MiB per workload] [workload]...
+
+#include "terminalwidget.h"
+
+#include <QApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+const int DefaultWorkloadSize = 16; // MiB
+const int ScreenLines = 24;
+
+char printable(int i)
+{
+    return '!' + i % 94;
+}
+
+QByteArray asciiWorkload(int size)
+{
+    QByteArray data;
+    data.reserve(size + 128);
+    for (int line = 0; data.size() < size; ++line) {
+        for (int i = 0; i < 79; ++i)
+            data += printable(line + i);
+        data += "\r\n";
+    }
+    return data;
+}
+
+QByteArray sgrWorkload(int size)
+{
+    QByteArray data;
+    data.reserve(size + 1024);
+    for (int line = 0; data.size() < size; ++line) {
+        for (int i = 0; i < 79; ++i) {
+            data += "\033[38;5;" + QByteArray::number((line + i) % 256) + 'm';
+            if (i % 8 == 0)
+                data += "\033[1;48;5;" + QByteArray::number((line * 7 + i) % 256) + 'm';
+            data += printable(line + i);
+        }
+        data += "\033[0m\r\n";
+    }
+    return data;
+}
+
+QByteArray unicodeWorkload(int size)
+{
+    const QList<QByteArray> words = {
+        QStringLiteral("漢字").toUtf8(),
+        QStringLiteral("ひらがな").toUtf8(),
+        QStringLiteral("カタカナ").toUtf8(),
+        QStringLiteral("한국어").toUtf8(),
+        QStringLiteral("Größe").toUtf8(),
+        QStringLiteral("ΑΒΓΔ").toUtf8(),
+        QStringLiteral("→✓€").toUtf8()
+    };
+
+    QByteArray data;
+    data.reserve(size + 1024);
+    for (int line = 0; data.size() < size; ++line) {
+        // Wide characters take two columns, stay well inside the screen width
+        for (int i = 0; i < 8; ++i)
+            data += words.at((line + i) % words.size()) + ' ';
+        data += "\r\n";
+    }
+    return data;
+}
+
+QByteArray scrollRegionWorkload(int size)
+{
+    QByteArray data("\033[2;" + QByteArray::number(ScreenLines - 1) + "r");
+    data.reserve(size + 1024);
+    for (int line = 0; data.size() < size; ++line) {
+        if (line % 16 == 0) {
+            // Reverse index at the top of the region scrolls it down
+            data += "\033[2;1H\033M";
+        }
+        data += "\033[" + QByteArray::number(ScreenLines - 1) + ";1H\n";
+        for (int i = 0; i < 79; ++i)
+            data += printable(line + i);
+    }
+    data += "\033[r";
+    return data;
+}
+
+QByteArray cursorWorkload(int size)
+{
+    QByteArray data;
+    data.reserve(size + 1024);
+    for (int frame = 0; data.size() < size; ++frame) {
+        // Full screen redraw in short runs, like a curses application
+        data += "\033[H";
+        for (int line = 1; line <= ScreenLines; ++line) {
+            for (int column = 1; column < 80; column += 10) {
+                data += "\033[" + QByteArray::number(line) + ';' + QByteArray::number(column) + 'H';
+                for (int i = 0; i < 10; ++i)
+                    data += printable(frame + line + column + i);
+            }
+        }
+    }
+    return data;
+}
+
+QByteArray longLineWorkload(int size)
+{
+    const int lineLength = 256 * 1024;
+
+    QByteArray data;
+    data.reserve(size + lineLength);
+    for (int line = 0; data.size() < size; ++line) {
+        for (int i = 0; i < lineLength; ++i)
+            data += printable(line + i);
+        data += "\r\n";
+    }
+    return data;
+}
+
+struct Workload {
+    const char *name;
+    QByteArray (*generate)(int size);
+};
+
+const Workload Workloads[] = {
+    { "ascii", asciiWorkload },
+    { "sgr", sgrWorkload },
+    { "unicode", unicodeWorkload },
+    { "scroll-region", scrollRegionWorkload },
+    { "cursor", cursorWorkload },
+    { "long-lines", longLineWorkload }
+};
+
+/// Resets the peak RSS of this process, returns false if the kernel does not support it
+bool resetPeakResidentSetSize()
+{
+    QFile file(QStringLiteral("/proc/self/clear_refs"));
+    return file.open(QIODevice::WriteOnly) && file.write("5") == 1;
+}
+
+qint64 peakResidentSetSize()
+{
+    QFile status(QStringLiteral("/proc/self/status"));
+    if (!status.open(QIODevice::ReadOnly))
+        return 0;
+    foreach (const QByteArray &line, status.readAll().split('\n')) {
+        if (line.startsWith("VmHWM:"))
+            return line.mid(6).trimmed().split(' ').first().toLongLong() * 1024;
+    }
+    return 0;
+}
+
+void writeAll(int fd, const QByteArray &data)
+{
+    int offset = 0;
+    while (offset < data.size()) {
+        const ssize_t size = write(fd, data.constData() + offset, data.size() - offset);
+        if (size > 0) {
+            offset += size;
+            continue;
+        }
+
+        if (size < 0 && errno != EAGAIN && errno != EINTR)
+            qFatal("Cannot write to the terminal: %s", strerror(errno));
+
+        // The terminal reads its side of the PTY from the event loop
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+    }
+}
+
+/// Waits until the terminal has processed everything written so far
+void waitForTerminal(TerminalWidget *terminal)
+{
+    QEventLoop loop;
+    QByteArray reply;
+    // In teletype mode the reply leaves the emulation through sendData(), not the PTY
+    const QMetaObject::Connection connection = QObject::connect(terminal, &QTermWidget::sendData,
+            [&](const char *data, int size) {
+        reply.append(data, size);
+        if (reply.contains('R'))
+            loop.quit();
+    });
+
+    // The cursor position report is only sent once all preceding output has been parsed
+    writeAll(terminal->getPtySlaveFd(), QByteArray("\033[6n"));
+    if (!reply.contains('R'))
+        loop.exec();
+    QObject::disconnect(connection);
+
+    // Let the last frame be painted
+    QCoreApplication::processEvents();
+}
+
+QJsonObject run(TerminalWidget *terminal, const Workload &workload, int size)
+{
+    const QByteArray data = workload.generate(size);
+    const int fd = terminal->getPtySlaveFd();
+
+    writeAll(fd, QByteArray("\033[2J\033[H"));
+    waitForTerminal(terminal);
+
+    const bool peakReset = resetPeakResidentSetSize();
+
+    QElapsedTimer timer;
+    timer.start();
+    writeAll(fd, data);
+    waitForTerminal(terminal);
+    const double seconds = timer.nsecsElapsed() / 1e9;
+
+    const int lines = data.count('\n');
+
+    QJsonObject result;
+    result.insert(QStringLiteral("workload"), QString::fromLatin1(workload.name));
+    result.insert(QStringLiteral("bytes"), data.size());
+    result.insert(QStringLiteral("lines"), lines);
+    result.insert(QStringLiteral("seconds"), seconds);
+    result.insert(QStringLiteral("mbPerSecond"), data.size() / seconds / (1024 * 1024));
+    result.insert(QStringLiteral("linesPerSecond"), lines / seconds);
+    if (peakReset)
+        result.insert(QStringLiteral("peakRssMiB"), peakResidentSetSize() / (1024.0 * 1024.0));
+    return result;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+    // Use default preferences rather than those of the user
+    app.setOrganizationName(QStringLiteral("QuickTerminalBench"));
+    app.setApplicationName(QStringLiteral("throughputbench"));
+
+    QStringList args = app.arguments();
+    args.removeFirst();
+
+    const int size = (args.isEmpty() ? DefaultWorkloadSize : args.takeFirst().toInt()) * 1024 * 1024;
+
+    // Output is written straight to the terminal, no process is started
+    TerminalWidget::setStartDeferred(true);
+    TerminalWidget terminal(QDir::currentPath());
+    terminal.resize(800, 600);
+    terminal.show();
+    terminal.startTerminalTeletype();
+
+    const int fd = terminal.getPtySlaveFd();
+    struct termios attributes;
+    if (tcgetattr(fd, &attributes) == 0) {
+        cfmakeraw(&attributes);
+        tcsetattr(fd, TCSANOW, &attributes);
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    QJsonArray results;
+    for (const Workload &workload : Workloads) {
+        if (args.isEmpty() || args.contains(QString::fromLatin1(workload.name)))
+            results.append(run(&terminal, workload, size));
+    }
+
+    QFile out;
+    out.open(stdout, QIODevice::WriteOnly);
+    out.write(QJsonDocument(results).toJson());
+
+    return 0;
+}
@@ -0,0 +1,5 @@
+include(../common.pri)
+
+TARGET = throughputbench
+
+SOURCES += main.cpp
@@ -0,0 +1,201 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+// Training workload for profile guided optimisation: starts windows, opens
+// tabs and splits, streams typical terminal output through real processes
+// and searches the scrollback. See pgo.sh.
+//
+// Usage: trainingdriver [rounds]
+
+#include "mainwindow.h"
+#include "outputscanner.h"
+#include "preferences.h"
+#include "spawnhelper.h"
+#include "tabwidget.h"
+#include "termwidgetholder.h"
+
+#include <QApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QLineEdit>
+#include <QTemporaryDir>
+
+namespace {
+const int DefaultRounds = 3;
+const int OutputSize = 4 * 1024 * 1024;
+const int Timeout = 60000; // ms
+
+QByteArray plainOutput(int size)
+{
+    QByteArray data;
+    for (int line = 0; data.size() < size; ++line) {
+        data += QByteArray::number(line) + ": ";
+        for (int i = 0; i < 72; ++i)
+            data += char('!' + (line + i) % 94);
+        data += "\r\n";
+    }
+    return data;
+}
+
+QByteArray colorOutput(int size)
+{
+    QByteArray data;
+    for (int line = 0; data.size() < size; ++line) {
+        for (int word = 0; word < 10; ++word) {
+            data += "\033[" + QByteArray::number(30 + (line + word) % 8) + 'm';
+            if (word % 3 == 0)
+                data += "\033[1m";
+            data += "word" + QByteArray::number(word) + "\033[0m ";
+        }
+        data += "\r\n";
+    }
+    return data;
+}
+
+QByteArray unicodeOutput(int size)
+{
+    const QByteArray line = QStringLiteral("Größe → 漢字 ひらがな 한국어 ΑΒΓΔ ✓\r\n").toUtf8();
+    QByteArray data;
+    while (data.size() < size)
+        data += line;
+    return data;
+}
+
+QByteArray fullScreenOutput(int size)
+{
+    QByteArray data("\033[?1049h");
+    for (int frame = 0; data.size() < size; ++frame) {
+        data += "\033[H\033[2J";
+        for (int line = 1; line <= 24; ++line) {
+            data += "\033[" + QByteArray::number(line) + ";1H\033[7m"
+                    + QByteArray::number(frame) + "\033[0m ";
+            data += QByteArray(60, char('a' + (frame + line) % 26));
+        }
+    }
+    data += "\033[?1049l";
+    return data;
+}
+
+void processEvents(int duration)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < duration)
+        QCoreApplication::processEvents(QEventLoop::AllEvents, duration - timer.elapsed());
+}
+
+/// Opens a tab running \a command and waits until it has exited
+void runInTab(TabWidget *tabWidget, const QString &command)
+{
+    const int tabs = tabWidget->count();
+    tabWidget->addNewTab(command);
+
+    QElapsedTimer timer;
+    timer.start();
+    while (tabWidget->count() > tabs && timer.elapsed() < Timeout)
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 100);
+}
+
+void search(TerminalWidget *terminal, const QStringList &patterns)
+{
+    terminal->toggleShowSearchBar();
+    QLineEdit *edit = terminal->findChild<QLineEdit *>();
+    if (edit) {
+        foreach (const QString &pattern, patterns) {
+            edit->setText(pattern);
+            processEvents(50);
+        }
+    }
+    terminal->toggleShowSearchBar();
+}
+
+void train(const QStringList &files)
+{
+    MainWindow window(QDir::currentPath(), QString());
+    window.setupMenus();
+    window.show();
+    processEvents(500);
+
+    TabWidget *tabWidget = window.tabWidget();
+
+    // Tabs and splits
+    for (int i = 0; i < 8; ++i)
+        tabWidget->addNewTab();
+    for (int i = 0; i < tabWidget->count(); ++i) {
+        tabWidget->setCurrentIndex(i);
+        tabWidget->splitHorizontally();
+        tabWidget->splitVertically();
+        tabWidget->switchNextSubterminal();
+        processEvents(50);
+    }
+    for (int i = 0; i < tabWidget->count(); ++i) {
+        tabWidget->setCurrentIndex(i);
+        tabWidget->splitCollapse();
+    }
+    while (tabWidget->count() > 1)
+        tabWidget->removeTab(tabWidget->count() - 1);
+
+    // Output, keeping a scrollback to search through in the last tab
+    foreach (const QString &file, files)
+        runInTab(tabWidget, QStringLiteral("cat ") + file);
+
+    tabWidget->addNewTab(QStringLiteral("cat ") + files.first() + QStringLiteral(" -"));
+    processEvents(2000);
+    search(tabWidget->terminalHolder()->currentTerminal(),
+           QStringList() << QStringLiteral("1234") << QStringLiteral("xyz")
+                         << QStringLiteral("[0-9]+:") << QStringLiteral("missing"));
+}
+}
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    OutputScanner::initialize();
+    if (!SpawnHelper::start())
+        qFatal("Cannot start the spawn helper");
+
+    QApplication app(argc, argv);
+    // Use default preferences rather than those of the user
+    app.setOrganizationName(QStringLiteral("QuickTerminalBench"));
+    app.setApplicationName(QStringLiteral("trainingdriver"));
+
+    const QStringList args = app.arguments();
+    const int rounds = args.size() > 1 ? args.at(1).toInt() : DefaultRounds;
+
+    QTemporaryDir dir;
+    QStringList files;
+    const QList<QByteArray> outputs = QList<QByteArray>() << plainOutput(OutputSize)
+            << colorOutput(OutputSize) << unicodeOutput(OutputSize)
+            << fullScreenOutput(OutputSize);
+    for (int i = 0; i < outputs.size(); ++i) {
+        QFile file(dir.path() + QStringLiteral("/output%1").arg(i));
+        if (!file.open(QIODevice::WriteOnly) || file.write(outputs.at(i)) != outputs.at(i).size())
+            qFatal("Cannot write training output");
+        files.append(file.fileName());
+    }
+
+    for (int i = 0; i < rounds; ++i)
+        train(files);
+
+    SpawnHelper::stop();
+    return 0;
+}
@@ -0,0 +1,35 @@
+#!/bin/sh
+# Builds a PGO and LTO optimised QuickTerminal.
+#
+# Usage: pgo.sh <source dir> <build dir>
+#
+# 1. Builds the training driver with instrumentation
+# 2. Runs it under the offscreen platform to record a profile
+# 3. Builds the application with the profile and link time optimisation
+#
+# Needs clang and llvm-profdata. The result is <build dir>/release/qt.
+
+set -e
+
+SOURCE_DIR=$(cd "$1" && pwd)
+BUILD_DIR=${2:-pgo}
+QMAKE=${QMAKE:-qmake}
+LLVM_PROFDATA=${LLVM_PROFDATA:-llvm-profdata}
+JOBS=${JOBS:-$(nproc)}
+
+mkdir -p "$BUILD_DIR/training" "$BUILD_DIR/release"
+BUILD_DIR=$(cd "$BUILD_DIR" && pwd)
+PROFILE="$BUILD_DIR/quickterminal.profdata"
+
+cd "$BUILD_DIR/training"
+"$QMAKE" -spec linux-clang CONFIG+=pgo_generate "$SOURCE_DIR/bench/training/training.pro"
+make -j"$JOBS"
+
+rm -f ./*.profraw
+LLVM_PROFILE_FILE="$BUILD_DIR/training/%p.profraw" QT_QPA_PLATFORM=offscreen ./trainingdriver
+"$LLVM_PROFDATA" merge -output="$PROFILE" ./*.profraw
+
+cd "$BUILD_DIR/release"
+"$QMAKE" -spec linux-clang CONFIG+=release CONFIG+=pgo_use PGO_PROFILE="$PROFILE" \
+    "$SOURCE_DIR/quickterminal.pro"
+make -j"$JOBS" qt
@@ -0,0 +1,7 @@
+include(../common.pri)
+
+TARGET = trainingdriver
+
+SOURCES += main.cpp
+
+OTHER_FILES += pgo.sh
@@ -0,0 +1,17 @@
+# Profile guided optimisation, needs clang (qmake -spec linux-clang).
+# Profiles are matched by function, so a profile recorded by the training
+# driver in bench/training applies to the application. "make pgo" runs all
+# steps, see README.
+
+pgo_generate {
+    QMAKE_CXXFLAGS += -fprofile-instr-generate
+    QMAKE_LFLAGS += -fprofile-instr-generate
+}
+
+pgo_use {
+    isEmpty(PGO_PROFILE): error("pgo_use needs PGO_PROFILE=<merged .profdata file>")
+    QMAKE_CXXFLAGS += -fprofile-instr-use=$$PGO_PROFILE \
+        -Wno-profile-instr-unprofiled -Wno-profile-instr-out-of-date
+    QMAKE_LFLAGS += -fprofile-instr-use=$$PGO_PROFILE
+    CONFIG += ltcg
+}
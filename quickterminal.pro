@@ -1,4 +1,4 @@
-QT += gui gui-private widgets
+QT += gui gui-private widgets network
 CONFIG += c++11 link_pkgconfig
 PKGCONFIG += qtermwidget5 x11
 
@@ -6,6 +6,8 @@ TARGET = qt
 
 DEFINES += STR_VERSION=\\\"1.0\\\"
 
+include(pgo.pri)
+
 # QxtGlobalShortcut
 HEADERS += $$files(src/3rdparty/*.h)
 SOURCES += $$files(src/3rdparty/*.cpp)
@@ -18,7 +20,17 @@ INCLUDEPATH += src src/3rdparty
 RESOURCES += src/icons.qrc
 FORMS += $$files(src/forms/*.ui)
 
-OTHER_FILES += $$files(desktop/*) AUTHORS COPYING README
+OTHER_FILES += $$files(desktop/*) AUTHORS COPYING README pgo.pri
+
+# "make bench" builds the benchmarks and runs the throughput benchmark
+bench.commands = $(MKDIR) bench && cd bench && $$QMAKE_QMAKE $$PWD/bench/bench.pro \
+    && $(MAKE) && QT_QPA_PLATFORM=offscreen throughput/throughputbench
+QMAKE_EXTRA_TARGETS += bench
+
+# "make pgo" builds an instrumented training driver, records a profile and
+# builds a PGO and LTO optimised binary in pgo/release
+pgo.commands = sh $$PWD/bench/training/pgo.sh $$PWD $$OUT_PWD/pgo
+QMAKE_EXTRA_TARGETS += pgo
 
 unix {
     isEmpty(PREFIX) {
@@ -115,13 +115,11 @@ void ActionManager::updateShortcut(const QString &id, const QKeySequence &shortc
     actionInfo.shortcut = shortcut;
     m_actionRegistry.insert(id, actionInfo);
 
+    // Actions are created on demand, an instance might not have this one yet
     foreach (ActionManager *am, m_instances) {
-        if (!am->m_actions.contains(id)) {
-            // This should never happen
-            qCritical("Action '%s' not found!", qPrintable(id));
-            continue;
-        }
-        am->m_actions.value(id)->setShortcut(shortcut);
+        if (am->m_actions.contains(id))
+            am->m_actions.value(id)->setShortcut(shortcut);
+        emit am->changed(id);
     }
 }
 
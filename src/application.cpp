@@ -21,11 +21,22 @@
 
 #include "actionmanager.h"
 #include "constants.h"
+#include "inputlatency.h"
+#include "instanceserver.h"
 #include "mainwindow.h"
+#include "metricsexporter.h"
 #include "preferences.h"
+#include "shellpool.h"
+#include "stalldetector.h"
+#include "startuptimer.h"
+#include "tabwidget.h"
+#include "terminalwidget.h"
+#include "termwidgetholder.h"
+#include "tracer.h"
 
 #include <QCommandLineParser>
 #include <QDir>
+#include <QEvent>
 
 #include <qxtglobalshortcut.h>
 
@@ -33,13 +44,26 @@ Application::Application(QObject *parent) :
     QObject(parent),
     m_preferences(Preferences::instance())
 {
+    StartupTimer::mark(QStringLiteral("Preferences loaded"));
+
     connect(Preferences::instance(), &Preferences::changed,
             this, &Application::preferencesChanged);
 
     parseOptions();
-    setupActions();
-    loadUserShortcuts();
+    StartupTimer::mark(QStringLiteral("Options parsed"));
+
+    ShellPool::instance()->setWorkingDirectory(m_workingDir);
+
+    // Get the first frame on screen before spawning shells and building menus
+    TerminalWidget::setStartDeferred(true);
     createWindow();
+    StartupTimer::mark(QStringLiteral("Window created"));
+
+    MainWindow *window = m_windows.first();
+    if (window->isVisible())
+        window->installEventFilter(this);
+    else
+        QMetaObject::invokeMethod(this, "finishStartup", Qt::QueuedConnection);
 }
 
 Application::~Application()
@@ -50,7 +74,15 @@ Application::~Application()
 
 void Application::createWindow()
 {
-    MainWindow *window = new MainWindow(m_workingDir, m_command);
+    openWindow(m_workingDir, m_command, m_dropDownMode, m_grid);
+}
+
+void Application::openWindow(const QString &workingDir, const QString &command,
+                             bool dropDownMode, const QSize &grid)
+{
+    MainWindow *window = new MainWindow(workingDir, command);
+    if (grid.isValid())
+        createGrid(window, grid);
 
     connect(window, &MainWindow::newWindow, this, &Application::createWindow);
     connect(window, &MainWindow::quit, this, &Application::quit);
@@ -58,16 +90,14 @@ void Application::createWindow()
 
     m_windows.append(window);
 
-    if (m_dropDownMode && m_windows.size() == 1) {
-        m_dropDownShortcut = new QxtGlobalShortcut(this);
-        m_dropDownShortcut->setShortcut(ActionManager::actionInfo(ActionId::ToggleVisibility).shortcut);
-        connect(m_dropDownShortcut, &QxtGlobalShortcut::activated,
-                [window]() {
-            if (window->isVisible())
-                window->hide();
-            else
-                window->show();
-        });
+    // Menus of the first window are created once it has been painted
+    if (m_started)
+        window->setupMenus();
+
+    if (dropDownMode && !m_dropDownWindow) {
+        m_dropDownWindow = window;
+        if (m_started)
+            setupDropDownShortcut();
         window->enableDropMode();
         if (!Preferences::instance()->dropShowOnStart)
             return;
@@ -76,6 +106,57 @@ void Application::createWindow()
     window->show();
 }
 
+bool Application::eventFilter(QObject *object, QEvent *event)
+{
+    if (event->type() == QEvent::Paint && !m_started) {
+        object->removeEventFilter(this);
+        StartupTimer::mark(QStringLiteral("First frame painted"));
+        // Let the paint finish first
+        QMetaObject::invokeMethod(this, "finishStartup", Qt::QueuedConnection);
+    }
+    return QObject::eventFilter(object, event);
+}
+
+void Application::finishStartup()
+{
+    if (m_started)
+        return;
+
+    setupActions();
+    StartupTimer::mark(QStringLiteral("Actions registered"));
+
+    loadUserShortcuts();
+    StartupTimer::mark(QStringLiteral("User shortcuts loaded"));
+
+    foreach (MainWindow *window, m_windows)
+        window->setupMenus();
+    setupDropDownShortcut();
+    StartupTimer::mark(QStringLiteral("Menus created"));
+
+    TerminalWidget::setStartDeferred(false);
+    StartupTimer::mark(QStringLiteral("Shells started"));
+
+    updateStallDetector();
+    updateMetricsExporter();
+    InputLatency::setEnabled(m_preferences->inputLatencyProbe);
+
+    if (m_serverMode) {
+        m_instanceServer = new InstanceServer(this);
+        if (m_instanceServer->listen()) {
+            connect(m_instanceServer, &InstanceServer::requestReceived,
+                    this, &Application::handleRequest);
+        } else {
+            m_keepRunning = false;
+        }
+        qApp->setQuitOnLastWindowClosed(!m_keepRunning);
+    }
+
+    m_started = true;
+
+    if (m_startupReport)
+        StartupTimer::report();
+}
+
 void Application::quit()
 {
     qApp->quit();
@@ -84,49 +165,164 @@ void Application::quit()
 void Application::preferencesChanged()
 {
     loadUserShortcuts();
+    updateStallDetector();
+    updateMetricsExporter();
+    InputLatency::setEnabled(m_preferences->inputLatencyProbe);
 }
 
 void Application::windowDeleted(QObject *object)
 {
     /// FIXME: Cast should be qobject_cast
     m_windows.removeAll(static_cast<MainWindow *>(object));
-    if (m_windows.isEmpty())
+
+    if (object == m_dropDownWindow) {
+        m_dropDownWindow = nullptr;
+        delete m_dropDownShortcut;
+        m_dropDownShortcut = nullptr;
+    }
+
+    if (m_windows.isEmpty() && !m_keepRunning)
         quit();
 }
 
-void Application::parseOptions()
+void Application::createGrid(MainWindow *window, const QSize &grid)
+{
+    TermWidgetHolder *holder = window->tabWidget()->terminalHolder();
+    holder->createGrid(holder->currentTerminal(), grid.height(), grid.width());
+}
+
+void Application::handleRequest(const QStringList &arguments, const QString &workingDir)
 {
     QCommandLineParser parser;
+    setupOptions(&parser);
+
+    if (!parser.parse(arguments)) {
+        qWarning("Ignoring request: %s", qPrintable(parser.errorText()));
+        return;
+    }
+
+    QString wd = workingDir;
+    if (parser.isSet(QStringLiteral("working-directory")))
+        wd = QDir(workingDir).absoluteFilePath(parser.value(QStringLiteral("working-directory")));
+    const QString command = parser.value(QStringLiteral("command"));
+    const QSize grid = TermWidgetHolder::parseGridSize(parser.value(QStringLiteral("grid")));
 
+    if (parser.isSet(QStringLiteral("dropdown"))) {
+        if (!m_dropDownWindow) {
+            openWindow(wd, command, true, grid);
+        } else if (parser.isSet(QStringLiteral("tab"))) {
+            m_dropDownWindow->addTab(wd, command);
+            if (grid.isValid())
+                createGrid(m_dropDownWindow, grid);
+        } else {
+            m_dropDownWindow->showHide();
+        }
+        return;
+    }
+
+    if (parser.isSet(QStringLiteral("tab"))) {
+        MainWindow *target = nullptr;
+        foreach (MainWindow *window, m_windows) {
+            if (window == m_dropDownWindow)
+                continue;
+            target = window;
+            if (window->isActiveWindow())
+                break;
+        }
+
+        if (target) {
+            target->addTab(wd, command);
+            if (grid.isValid())
+                createGrid(target, grid);
+            return;
+        }
+    }
+
+    openWindow(wd, command, false, grid);
+}
+
+void Application::setupOptions(QCommandLineParser *parser)
+{
     QCommandLineOption dropDownOption(
     {QStringLiteral("d"), QStringLiteral("dropdown")},
                 QStringLiteral("Run in 'dropdown mode' (like Yakuake or Tilda)"));
-    parser.addOption(dropDownOption);
+    parser->addOption(dropDownOption);
 
     QCommandLineOption commandOption(
     {QStringLiteral("e"), QStringLiteral("command")},
                 QStringLiteral("Specify a command to execute inside the terminal"),
                 QStringLiteral("COMMAND"));
-    parser.addOption(commandOption);
+    parser->addOption(commandOption);
 
     QCommandLineOption workingDirectoryOption(
     {QStringLiteral("w"), QStringLiteral("working-directory")},
                 QStringLiteral("Set the working directory"),
                 QStringLiteral("DIR"), QDir::currentPath());
-    parser.addOption(workingDirectoryOption);
+    parser->addOption(workingDirectoryOption);
+
+    QCommandLineOption gridOption(
+                QStringLiteral("grid"),
+                QStringLiteral("Split the terminal into a grid of ROWSxCOLUMNS terminals"),
+                QStringLiteral("ROWSxCOLUMNS"));
+    parser->addOption(gridOption);
 
-    parser.addHelpOption();
-    parser.addVersionOption();
+    QCommandLineOption tabOption(
+    {QStringLiteral("t"), QStringLiteral("tab")},
+                QStringLiteral("Open a new tab instead of a new window (with --client)"));
+    parser->addOption(tabOption);
+
+    QCommandLineOption serverOption(
+                QStringLiteral("server"),
+                QStringLiteral("Accept requests from instances started with --client"));
+    parser->addOption(serverOption);
+
+    QCommandLineOption clientOption(
+                QStringLiteral("client"),
+                QStringLiteral("Open the window in a running server instance, "
+                               "or become the server if there is none"));
+    parser->addOption(clientOption);
+
+    QCommandLineOption startupReportOption(
+                QStringLiteral("startup-report"),
+                QStringLiteral("Print how long each startup phase took"));
+    parser->addOption(startupReportOption);
+
+    QCommandLineOption traceOption(
+                QStringLiteral("trace"),
+                QStringLiteral("Record a Chrome/Perfetto trace of the whole session to FILE"),
+                QStringLiteral("FILE"));
+    parser->addOption(traceOption);
+
+    parser->addHelpOption();
+    parser->addVersionOption();
+}
+
+void Application::parseOptions()
+{
+    QCommandLineParser parser;
+    setupOptions(&parser);
 
     parser.process(qApp->arguments());
 
-    m_dropDownMode = parser.isSet(dropDownOption);
-    m_command = parser.value(commandOption);
-    m_workingDir = parser.value(workingDirectoryOption);
+    m_dropDownMode = parser.isSet(QStringLiteral("dropdown"));
+    m_command = parser.value(QStringLiteral("command"));
+    m_workingDir = parser.value(QStringLiteral("working-directory"));
+    if (parser.isSet(QStringLiteral("grid"))) {
+        const QString grid = parser.value(QStringLiteral("grid"));
+        m_grid = TermWidgetHolder::parseGridSize(grid);
+        if (!m_grid.isValid())
+            qWarning("Ignoring invalid grid size '%s'.", qPrintable(grid));
+    }
+    m_serverMode = parser.isSet(QStringLiteral("server")) || parser.isSet(QStringLiteral("client"));
+    // A dedicated server stays around to serve clients after its last window is closed
+    m_keepRunning = parser.isSet(QStringLiteral("server"));
+    m_startupReport = parser.isSet(QStringLiteral("startup-report"));
 }
 
 void Application::setupActions()
 {
+    TRACE_SCOPE("Application::setupActions");
+
     // Application
     ActionManager::registerAction(ActionId::About, tr("&About %1").arg(qApp->applicationName()),
                                   QIcon::fromTheme(QStringLiteral("help-about")));
@@ -137,6 +333,8 @@ void Application::setupActions()
     ActionManager::registerAction(ActionId::Exit, tr("E&xit"),
                                   QKeySequence(QStringLiteral("Ctrl+Shift+X")),
                                   QIcon::fromTheme(QStringLiteral("application-exit")));
+    ActionManager::registerAction(ActionId::ToggleTracing, tr("Record &Trace"));
+    ActionManager::registerAction(ActionId::ShowEventLoopLatency, tr("Event Loop &Latency..."));
 
     // Window
     ActionManager::registerAction(ActionId::NewWindow, tr("New &Window..."),
@@ -148,6 +346,7 @@ void Application::setupActions()
     ActionManager::registerAction(ActionId::ShowMenu, tr("Show &Menu"),
                                   QKeySequence(QStringLiteral("Ctrl+Shift+M")));
     ActionManager::registerAction(ActionId::ShowTabs, tr("Show &Tabs"));
+    ActionManager::registerAction(ActionId::ShowResourceMonitor, tr("Resource &Monitor"));
     ActionManager::registerAction(ActionId::ToggleVisibility, tr("Toggle Visibility"),
                                   QKeySequence(QStringLiteral("F12")));
 
@@ -167,9 +366,18 @@ void Application::setupActions()
                                   QKeySequence(QStringLiteral("Ctrl+Shift+H")));
     ActionManager::registerAction(ActionId::SplitVertically, tr("Split &Vertically"),
                                   QKeySequence(QStringLiteral("Ctrl+Shift+V")));
+    ActionManager::registerAction(ActionId::SplitGrid, tr("Split into &Grid..."));
     ActionManager::registerAction(ActionId::CloseTerminal, tr("Close"),
                                   QKeySequence(QStringLiteral("Ctrl+Shift+D")),
                                   QIcon::fromTheme(QStringLiteral("window-close")));
+    ActionManager::registerAction(ActionId::FocusLeft, tr("&Left"),
+                                  QKeySequence(QStringLiteral("Alt+Shift+Left")));
+    ActionManager::registerAction(ActionId::FocusRight, tr("&Right"),
+                                  QKeySequence(QStringLiteral("Alt+Shift+Right")));
+    ActionManager::registerAction(ActionId::FocusUp, tr("&Up"),
+                                  QKeySequence(QStringLiteral("Alt+Shift+Up")));
+    ActionManager::registerAction(ActionId::FocusDown, tr("&Down"),
+                                  QKeySequence(QStringLiteral("Alt+Shift+Down")));
     ActionManager::registerAction(ActionId::Copy, tr("&Copy"),
                                   QKeySequence(QStringLiteral("Ctrl+Ins")),
                                   QIcon::fromTheme(QStringLiteral("edit-copy")));
@@ -199,6 +407,61 @@ void Application::setupActions()
                                   QIcon::fromTheme(QStringLiteral("zoom-original")));
 }
 
+void Application::setupDropDownShortcut()
+{
+    if (!m_dropDownWindow || m_dropDownShortcut)
+        return;
+
+    MainWindow *window = m_dropDownWindow;
+    m_dropDownShortcut = new QxtGlobalShortcut(this);
+    m_dropDownShortcut->setShortcut(ActionManager::actionInfo(ActionId::ToggleVisibility).shortcut);
+    connect(m_dropDownShortcut, &QxtGlobalShortcut::activated,
+            [window]() {
+        if (window->isVisible())
+            window->hide();
+        else
+            window->show();
+    });
+}
+
+void Application::updateStallDetector()
+{
+    StallDetector *detector = StallDetector::instance();
+    if (!m_preferences->stallDetector) {
+        detector->stop();
+        return;
+    }
+
+    if (detector->threshold() != m_preferences->stallThreshold)
+        detector->stop();
+    detector->start(m_preferences->stallThreshold);
+}
+
+void Application::updateMetricsExporter()
+{
+    const MetricsExporter::Mode mode
+            = static_cast<MetricsExporter::Mode>(m_preferences->metricsExport);
+    if (mode == MetricsExporter::Disabled) {
+        delete m_metricsExporter;
+        m_metricsExporter = nullptr;
+        return;
+    }
+
+    if (!m_metricsExporter)
+        m_metricsExporter = new MetricsExporter(this);
+
+    const QString path = m_preferences->metricsPath.isEmpty()
+            ? MetricsExporter::defaultPath(mode) : m_preferences->metricsPath;
+    const int interval = qMax(1, m_preferences->metricsInterval);
+    if (m_metricsExporter->mode() == mode && m_metricsExporter->path() == path
+            && m_metricsExporter->interval() == interval) {
+        return;
+    }
+
+    m_metricsExporter->stop();
+    m_metricsExporter->start(mode, path, interval);
+}
+
 void Application::loadUserShortcuts()
 {
     foreach (const QString &id, m_preferences->shortcutActions())
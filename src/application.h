@@ -21,10 +21,14 @@
 #define APPLICATION_H
 
 #include <QObject>
+#include <QSize>
 
+class QCommandLineParser;
 class QxtGlobalShortcut;
 
+class InstanceServer;
 class MainWindow;
+class MetricsExporter;
 class Preferences;
 
 class Application : public QObject
@@ -34,20 +38,33 @@ public:
     explicit Application(QObject *parent = nullptr);
     ~Application() override;
 
+    static void setupActions();
+
 signals:
 
 public slots:
     void createWindow();
     void quit();
 
+protected:
+    bool eventFilter(QObject *object, QEvent *event) override;
+
 private slots:
+    void finishStartup();
     void preferencesChanged();
     void windowDeleted(QObject *object);
+    void handleRequest(const QStringList &arguments, const QString &workingDir);
 
 private:
+    static void setupOptions(QCommandLineParser *parser);
     void parseOptions();
-    void setupActions();
+    void openWindow(const QString &workingDir, const QString &command, bool dropDownMode,
+                    const QSize &grid = QSize());
+    static void createGrid(MainWindow *window, const QSize &grid);
     void loadUserShortcuts();
+    void setupDropDownShortcut();
+    void updateStallDetector();
+    void updateMetricsExporter();
 
     Preferences * const m_preferences = nullptr;
     QList<MainWindow *> m_windows;
@@ -56,7 +73,16 @@ private:
     QString m_command;
     bool m_dropDownMode = false;
     QString m_workingDir;
+    QSize m_grid;
+    bool m_serverMode = false;
+    bool m_keepRunning = false;
+    bool m_startupReport = false;
+
+    bool m_started = false;
 
+    InstanceServer *m_instanceServer = nullptr;
+    MetricsExporter *m_metricsExporter = nullptr;
+    MainWindow *m_dropDownWindow = nullptr;
     QxtGlobalShortcut *m_dropDownShortcut = nullptr;
 };
 
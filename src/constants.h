@@ -26,12 +26,15 @@ const char About[] = "QuickTerminal.Application.About";
 const char AboutQt[] = "QuickTerminal.Application.AboutQt";
 const char Preferences[] = "QuickTerminal.Application.Preferences";
 const char Exit[] = "QuickTerminal.Application.Exit";
+const char ToggleTracing[] = "QuickTerminal.Application.ToggleTracing";
+const char ShowEventLoopLatency[] = "QuickTerminal.Application.ShowEventLoopLatency";
 
 // Window
 const char NewWindow[] = "QuickTerminal.Window.New";
 const char CloseWindow[] = "QuickTerminal.Window.Close";
 const char ShowMenu[] = "QuickTerminal.Window.ShowMenu";
 const char ShowTabs[] = "QuickTerminal.Window.ShowTabs";
+const char ShowResourceMonitor[] = "QuickTerminal.Window.ShowResourceMonitor";
 const char ToggleVisibility[] = "QuickTerminal.Window.ToggleVisibility"; // DropDown Mode
 
 // Tab
@@ -43,7 +46,12 @@ const char PreviousTab[] = "QuickTerminal.Tab.Previous";
 // Terminal
 const char SplitHorizontally[] = "QuickTerminal.Terminal.SplitHorizontally";
 const char SplitVertically[] = "QuickTerminal.Terminal.SplitVertically";
+const char SplitGrid[] = "QuickTerminal.Terminal.SplitGrid";
 const char CloseTerminal[] = "QuickTerminal.Terminal.Close";
+const char FocusLeft[] = "QuickTerminal.Terminal.FocusLeft";
+const char FocusRight[] = "QuickTerminal.Terminal.FocusRight";
+const char FocusUp[] = "QuickTerminal.Terminal.FocusUp";
+const char FocusDown[] = "QuickTerminal.Terminal.FocusDown";
 const char Copy[] = "QuickTerminal.Terminal.Copy";
 const char Paste[] = "QuickTerminal.Terminal.Paste";
 const char PasteSelection[] = "QuickTerminal.Terminal.PasteSelection";
@@ -0,0 +1,90 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#include "inputlatency.h"
+
+#include <algorithm>
+
+namespace {
+const int MaxSamples = 10000;
+}
+
+bool InputLatency::m_enabled = false;
+QElapsedTimer InputLatency::m_clock;
+QVector<qint64> InputLatency::m_samples[2];
+int InputLatency::m_next[2];
+
+bool InputLatency::isEnabled()
+{
+    return m_enabled;
+}
+
+void InputLatency::setEnabled(bool enabled)
+{
+    m_enabled = enabled;
+    if (enabled && !m_clock.isValid())
+        m_clock.start();
+}
+
+/// Returns microseconds on a monotonic clock
+qint64 InputLatency::now()
+{
+    return m_clock.nsecsElapsed() / 1000;
+}
+
+void InputLatency::addSample(qint64 latency, bool busy)
+{
+    QVector<qint64> &samples = m_samples[busy];
+    if (samples.size() < MaxSamples) {
+        samples.append(latency);
+        return;
+    }
+
+    samples[m_next[busy]] = latency;
+    m_next[busy] = (m_next[busy] + 1) % MaxSamples;
+}
+
+int InputLatency::sampleCount()
+{
+    return m_samples[false].size() + m_samples[true].size();
+}
+
+InputLatency::Summary InputLatency::summary(bool busy)
+{
+    QVector<qint64> samples = m_samples[busy];
+    Summary summary;
+    if (samples.isEmpty())
+        return summary;
+
+    std::sort(samples.begin(), samples.end());
+    summary.count = samples.size();
+    summary.p50 = samples.at(samples.size() / 2);
+    summary.p99 = samples.at(samples.size() * 99 / 100);
+    summary.max = samples.last();
+    return summary;
+}
+
+void InputLatency::clear()
+{
+    for (int i = 0; i < 2; ++i) {
+        m_samples[i].clear();
+        m_next[i] = 0;
+    }
+}
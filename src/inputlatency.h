@@ -0,0 +1,60 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#ifndef INPUTLATENCY_H
+#define INPUTLATENCY_H
+
+#include <QElapsedTimer>
+#include <QVector>
+
+/*! \brief Keypress to paint latency probe.
+
+Terminals report the time from a key press to the end of the first paint
+after its echo has been read from the PTY. Samples are kept separately for
+key presses during which other terminals were producing output, so the cost
+of heavy output on typing shows up. Only the latest samples are kept.
+*/
+class InputLatency
+{
+public:
+    struct Summary {
+        int count = 0;
+        qint64 p50 = 0; // us
+        qint64 p99 = 0;
+        qint64 max = 0;
+    };
+
+    static bool isEnabled();
+    static void setEnabled(bool enabled);
+
+    static qint64 now();
+    static void addSample(qint64 latency, bool busy);
+    static int sampleCount();
+    static Summary summary(bool busy);
+    static void clear();
+
+private:
+    static bool m_enabled;
+    static QElapsedTimer m_clock;
+    static QVector<qint64> m_samples[2];
+    static int m_next[2];
+};
+
+#endif // INPUTLATENCY_H
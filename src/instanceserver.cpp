@@ -0,0 +1,151 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+#include "instanceserver.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QStandardPaths>
+
+namespace {
+const int ConnectTimeout = 500; // ms
+const int WriteTimeout = 2000; // ms
+const quint32 ProtocolVersion = 1;
+}
+
+InstanceServer::InstanceServer(QObject *parent) :
+    QObject(parent),
+    m_server(new QLocalServer(this))
+{
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(m_server, &QLocalServer::newConnection, this, &InstanceServer::acceptConnection);
+}
+
+InstanceServer::~InstanceServer()
+{
+    m_server->close();
+}
+
+bool InstanceServer::listen()
+{
+    const QString name = socketName();
+    if (m_server->listen(name))
+        return true;
+
+    if (m_server->serverError() != QAbstractSocket::AddressInUseError) {
+        qWarning("Cannot listen on '%s': %s", qPrintable(name),
+                 qPrintable(m_server->errorString()));
+        return false;
+    }
+
+    // Either another server is running, or a previous one left a stale socket behind
+    QLocalSocket socket;
+    socket.connectToServer(name);
+    if (socket.waitForConnected(ConnectTimeout)) {
+        qWarning("Another instance is already listening on '%s'.", qPrintable(name));
+        return false;
+    }
+
+    QLocalServer::removeServer(name);
+    return m_server->listen(name);
+}
+
+QString InstanceServer::socketName()
+{
+    QString path = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (path.isEmpty())
+        path = QDir::tempPath();
+    return QDir(path).absoluteFilePath(QStringLiteral("quickterminal-server"));
+}
+
+bool InstanceServer::sendRequest(const QStringList &arguments)
+{
+    QLocalSocket socket;
+    socket.connectToServer(socketName());
+    if (!socket.waitForConnected(ConnectTimeout))
+        return false;
+
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out << ProtocolVersion << arguments << QDir::currentPath();
+
+    QDataStream stream(&socket);
+    stream << static_cast<quint32>(payload.size());
+    socket.write(payload);
+
+    while (socket.bytesToWrite() > 0) {
+        if (!socket.waitForBytesWritten(WriteTimeout))
+            return false;
+    }
+
+    socket.disconnectFromServer();
+    return true;
+}
+
+void InstanceServer::acceptConnection()
+{
+    while (QLocalSocket *socket = m_server->nextPendingConnection()) {
+        connect(socket, &QLocalSocket::readyRead, this, &InstanceServer::readRequest);
+        connect(socket, &QLocalSocket::disconnected, socket, &QLocalSocket::deleteLater);
+    }
+}
+
+void InstanceServer::readRequest()
+{
+    QLocalSocket *socket = qobject_cast<QLocalSocket *>(sender());
+    Q_ASSERT(socket);
+
+    // Each request is a payload prefixed with its size
+    const qint64 headerSize = sizeof(quint32);
+    if (socket->bytesAvailable() < headerSize)
+        return;
+
+    quint32 size;
+    QDataStream header(socket->peek(headerSize));
+    header >> size;
+    if (socket->bytesAvailable() < headerSize + size)
+        return;
+
+    socket->read(headerSize);
+    const QByteArray payload = socket->read(size);
+
+    quint32 version;
+    QStringList arguments;
+    QString workingDir;
+
+    QDataStream in(payload);
+    in >> version;
+    if (version != ProtocolVersion) {
+        qWarning("Ignoring request with unsupported protocol version %u.", version);
+        socket->disconnectFromServer();
+        return;
+    }
+
+    in >> arguments >> workingDir;
+    if (in.status() != QDataStream::Ok || arguments.isEmpty()) {
+        qWarning("Ignoring malformed request.");
+        socket->disconnectFromServer();
+        return;
+    }
+
+    emit requestReceived(arguments, workingDir);
+    socket->disconnectFromServer();
+}
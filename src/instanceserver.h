@@ -0,0 +1,59 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+#ifndef INSTANCESERVER_H
+#define INSTANCESERVER_H
+
+#include <QObject>
+#include <QStringList>
+
+class QLocalServer;
+class QLocalSocket;
+
+/*! \brief Per-user local socket server for single-instance mode.
+
+The first process started with --server (or with --client, when no server is
+running yet) listens on a socket in the user's runtime directory. Processes
+started with --client forward their command line to it and exit, so opening
+a new window or tab does not pay for a full application startup.
+*/
+class InstanceServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit InstanceServer(QObject *parent = nullptr);
+    ~InstanceServer() override;
+
+    bool listen();
+
+    static QString socketName();
+    static bool sendRequest(const QStringList &arguments);
+
+signals:
+    void requestReceived(const QStringList &arguments, const QString &workingDir);
+
+private slots:
+    void acceptConnection();
+    void readRequest();
+
+private:
+    QLocalServer *m_server = nullptr;
+};
+
+#endif // INSTANCESERVER_H
@@ -20,19 +20,77 @@
 ****************************************************************************/
 
 #include "application.h"
+#include "instanceserver.h"
+#include "outputscanner.h"
+#include "spawnhelper.h"
+#include "startuptimer.h"
+#include "tracer.h"
 
 #include <QApplication>
 
+namespace {
+bool hasArgument(int argc, char *argv[], const char *name)
+{
+    for (int i = 1; i < argc; ++i) {
+        if (!qstrcmp(argv[i], name))
+            return true;
+    }
+    return false;
+}
+
+QString argumentValue(int argc, char *argv[], const char *name)
+{
+    const QByteArray prefix = QByteArray(name) + '=';
+    for (int i = 1; i < argc; ++i) {
+        if (!qstrcmp(argv[i], name) && i + 1 < argc)
+            return QString::fromLocal8Bit(argv[i + 1]);
+        if (!qstrncmp(argv[i], prefix.constData(), prefix.size()))
+            return QString::fromLocal8Bit(argv[i] + prefix.size());
+    }
+    return QString();
+}
+}
+
 int main(int argc, char *argv[])
 {
+    StartupTimer::start();
+
+    // Tracing starts before anything else, so that startup is covered too
+    const QString traceFile = argumentValue(argc, argv, "--trace");
+    if (!traceFile.isEmpty())
+        Tracer::start(traceFile);
+    const qint64 mainStart = Tracer::now();
+
     setenv("TERM", "xterm", 1); // TODO/FIXME: why?
 
     QApplication::setApplicationName(QStringLiteral("QuickTerminal"));
     QApplication::setApplicationVersion(QStringLiteral(STR_VERSION));
     QApplication::setOrganizationName(QStringLiteral("QuickTerminal"));
 
+    // Hand the request over to a running instance without setting up the GUI
+    if (hasArgument(argc, argv, "--client") && !hasArgument(argc, argv, "--help")
+            && !hasArgument(argc, argv, "-h") && !hasArgument(argc, argv, "--version")
+            && !hasArgument(argc, argv, "-v")) {
+        QCoreApplication capp(argc, argv);
+        if (InstanceServer::sendRequest(capp.arguments()))
+            return 0;
+    }
+
+    // Picked before the PTY reactor thread can scan output
+    OutputScanner::initialize();
+
+    // Fork the spawn helper while the process is still small
+    SpawnHelper::start();
+    StartupTimer::mark(QStringLiteral("Spawn helper started"));
+
     QScopedPointer<QApplication> qapp(new QApplication(argc, argv));
+    StartupTimer::mark(QStringLiteral("QApplication created"));
+
     QScopedPointer<Application> app(new Application());
+    if (Tracer::isEnabled())
+        Tracer::addSpan("main", mainStart, Tracer::now());
 
-    return qapp->exec();
+    const int result = qapp->exec();
+    Tracer::stop();
+    return result;
 }
@@ -23,13 +23,21 @@
 
 #include "actionmanager.h"
 #include "constants.h"
+#include "inputlatency.h"
 #include "preferences.h"
 #include "preferencesdialog.h"
+#include "resourcemonitor.h"
+#include "stalldetector.h"
 #include "termwidgetholder.h"
 #include "tabwidget.h"
+#include "tracer.h"
+#include "windowshortcuts.h"
 
 #include <QCloseEvent>
+#include <QDateTime>
+#include <QDir>
 #include <QDesktopWidget>
+#include <QInputDialog>
 #include <QMenu>
 #include <QMenuBar>
 #include <QMessageBox>
@@ -41,6 +49,8 @@ MainWindow::MainWindow(const QString &workingDir, const QString &command, QWidge
     m_preferences(Preferences::instance()),
     m_actionManager(new ActionManager(this))
 {
+    TRACE_SCOPE("MainWindow::MainWindow");
+
     /// TODO: Check why it is not set by default
     setAttribute(Qt::WA_DeleteOnClose);
 
@@ -49,6 +59,11 @@ MainWindow::MainWindow(const QString &workingDir, const QString &command, QWidge
     m_tabWidget = new TabWidget(this);
     connect(m_tabWidget, &TabWidget::lastTabClosed, this, &MainWindow::close);
 
+    // Cheap while empty; populated on first show, so it works before setupMenus()
+    m_contextMenu = new QMenu(this);
+    connect(m_contextMenu, &QMenu::aboutToShow, this, &MainWindow::setupContextMenu);
+    m_tabWidget->setContextMenu(m_contextMenu);
+
     m_tabWidget->tabBar()->setVisible(!m_preferences->hideTabBar);
     m_tabWidget->setWorkDirectory(workingDir);
     m_tabWidget->setTabPosition((QTabWidget::TabPosition)m_preferences->tabBarPosition);
@@ -58,13 +73,6 @@ MainWindow::MainWindow(const QString &workingDir, const QString &command, QWidge
     setWindowTitle(qApp->applicationName());
     setWindowIcon(QIcon::fromTheme(QStringLiteral("utilities-terminal"), QIcon(Icon::Application)));
 
-    setupFileMenu();
-    setupEditMenu();
-    setupViewMenu();
-    setupHelpMenu();
-    setupContextMenu();
-    setupWindowActions();
-
     setContentsMargins(0, 0, 0, 0);
     if (!restoreGeometry(m_preferences->mainWindowGeometry))
         resize(800, 600);
@@ -86,115 +94,212 @@ void MainWindow::enableDropMode()
     realign();
 }
 
-void MainWindow::setupFileMenu()
+void MainWindow::setupMenus()
 {
-    QMenu *menu = new QMenu(tr("&File"), menuBar());
-
-    QAction *action;
-    action = m_actionManager->action(ActionId::NewTab);
-    connect(action, SIGNAL(triggered()), m_tabWidget, SLOT(addNewTab()));
-    addAction(action);
-    menu->addAction(action);
-
-    action = m_actionManager->action(ActionId::CloseTab);
-    connect(action, &QAction::triggered, m_tabWidget, &TabWidget::removeCurrentTab);
-    addAction(action);
-    menu->addAction(action);
-
-    menu->addSeparator();
+    // Menus are populated when they are opened for the first time
+    setupMenu(tr("&File"), &MainWindow::setupFileMenu);
+    setupMenu(tr("&Edit"), &MainWindow::setupEditMenu);
+    setupMenu(tr("&View"), &MainWindow::setupViewMenu);
+    setupMenu(tr("&Help"), &MainWindow::setupHelpMenu);
+
+    // Shortcuts have to work before any menu is opened, without creating actions for them
+    WindowShortcuts::instance()->attach(this);
+}
 
-    action = m_actionManager->action(ActionId::NewWindow);
-    connect(action, &QAction::triggered, this, &MainWindow::newWindow);
-    addAction(action);
-    menu->addAction(action);
+/// Whether windows have a handler for the action, others are application-wide or unused
+bool MainWindow::handlesAction(const QString &id)
+{
+    return id != ActionId::ToggleVisibility && id != ActionId::SelectAll;
+}
 
-    action = m_actionManager->action(ActionId::CloseWindow);
-    connect(action, &QAction::triggered, this, &MainWindow::close);
-    addAction(action);
-    menu->addAction(action);
+/// Runs the action of this window, used by shortcuts shared by all windows
+void MainWindow::triggerAction(const QString &id)
+{
+    if (QAction *action = windowAction(id))
+        action->trigger();
+}
 
-    menu->addSeparator();
+void MainWindow::addTab(const QString &workingDir, const QString &command)
+{
+    m_tabWidget->addNewTab(command, workingDir);
 
-    action = m_actionManager->action(ActionId::Exit);
-    connect(action, &QAction::triggered, this, &MainWindow::quit);
-    addAction(action);
-    menu->addAction(action);
+    if (m_dropDownMode && !isVisible()) {
+        showHide();
+        return;
+    }
 
-    menuBar()->addMenu(menu);
+    show();
+    raise();
+    activateWindow();
 }
 
-void MainWindow::setupEditMenu()
+TabWidget *MainWindow::tabWidget() const
 {
-    QMenu *menu = new QMenu(tr("&Edit"), menuBar());
+    return m_tabWidget;
+}
 
-    QAction *action;
-    action = m_actionManager->action(ActionId::Copy);
-    connect(action, &QAction::triggered, [this]() {
-        currentTerminal()->copyClipboard();
+void MainWindow::setupMenu(const QString &title, void (MainWindow::*setup)(QMenu *))
+{
+    QMenu *menu = new QMenu(title, menuBar());
+    connect(menu, &QMenu::aboutToShow, this, [this, menu, setup]() {
+        if (menu->isEmpty())
+            (this->*setup)(menu);
+
+        // Tracing may have been toggled from another window or the command line
+        if (m_windowActions.contains(ActionId::ToggleTracing))
+            windowAction(ActionId::ToggleTracing)->setChecked(Tracer::isEnabled());
     });
-    addAction(action);
-    menu->addAction(action);
+    menuBar()->addMenu(menu);
+}
 
-    action = m_actionManager->action(ActionId::Paste);
-    connect(action, &QAction::triggered, [this]() {
-        currentTerminal()->pasteClipboard();
-    });
-    addAction(action);
-    menu->addAction(action);
+QAction *MainWindow::windowAction(const QString &id)
+{
+    QAction *action = m_actionManager->action(id);
+    if (!action || m_windowActions.contains(id))
+        return action;
+
+    m_windowActions.insert(id);
+
+    // Application
+    if (id == ActionId::About) {
+        connect(action, &QAction::triggered, this, &MainWindow::showAboutMessageBox);
+    } else if (id == ActionId::AboutQt) {
+        connect(action, &QAction::triggered, qApp, &QApplication::aboutQt);
+    } else if (id == ActionId::Preferences) {
+        connect(action, &QAction::triggered, this, &MainWindow::showPreferencesDialog);
+    } else if (id == ActionId::Exit) {
+        connect(action, &QAction::triggered, this, &MainWindow::quit);
+    } else if (id == ActionId::ToggleTracing) {
+        action->setCheckable(true);
+        action->setChecked(Tracer::isEnabled());
+        connect(action, &QAction::triggered, this, &MainWindow::toggleTracing);
+    } else if (id == ActionId::ShowEventLoopLatency) {
+        connect(action, &QAction::triggered, this, &MainWindow::showEventLoopLatency);
+    }
+    // Window
+    else if (id == ActionId::NewWindow) {
+        connect(action, &QAction::triggered, this, &MainWindow::newWindow);
+    } else if (id == ActionId::CloseWindow) {
+        connect(action, &QAction::triggered, this, &MainWindow::close);
+    } else if (id == ActionId::ShowMenu) {
+        action->setCheckable(true);
+        action->setChecked(m_preferences->menuVisible);
+        connect(action, &QAction::triggered, this, &MainWindow::toggleMenuBar);
+    } else if (id == ActionId::ShowTabs) {
+        action->setCheckable(true);
+        action->setChecked(!m_preferences->hideTabBar);
+        connect(action, &QAction::triggered, this, &MainWindow::toggleTabBar);
+    } else if (id == ActionId::ShowResourceMonitor) {
+        action->setCheckable(true);
+        action->setChecked(m_resourceMonitor && m_resourceMonitor->isVisible());
+        connect(action, &QAction::triggered, this, &MainWindow::toggleResourceMonitor);
+    }
+    // Tab
+    else if (id == ActionId::NewTab) {
+        connect(action, SIGNAL(triggered()), m_tabWidget, SLOT(addNewTab()));
+    } else if (id == ActionId::CloseTab) {
+        connect(action, &QAction::triggered, m_tabWidget, &TabWidget::removeCurrentTab);
+    } else if (id == ActionId::NextTab) {
+        connect(action, &QAction::triggered, m_tabWidget, &TabWidget::switchToRight);
+    } else if (id == ActionId::PreviousTab) {
+        connect(action, &QAction::triggered, m_tabWidget, &TabWidget::switchToLeft);
+    }
+    // Terminal
+    else if (id == ActionId::SplitHorizontally) {
+        connect(action, &QAction::triggered, m_tabWidget, &TabWidget::splitHorizontally);
+    } else if (id == ActionId::SplitVertically) {
+        connect(action, &QAction::triggered, m_tabWidget, &TabWidget::splitVertically);
+    } else if (id == ActionId::SplitGrid) {
+        connect(action, &QAction::triggered, this, &MainWindow::splitGrid);
+    } else if (id == ActionId::CloseTerminal) {
+        connect(action, &QAction::triggered, m_tabWidget, &TabWidget::splitCollapse);
+    } else if (id == ActionId::FocusLeft) {
+        connect(action, &QAction::triggered, [this]() {
+            m_tabWidget->terminalHolder()->focusTerminal(TermWidgetHolder::Left);
+        });
+    } else if (id == ActionId::FocusRight) {
+        connect(action, &QAction::triggered, [this]() {
+            m_tabWidget->terminalHolder()->focusTerminal(TermWidgetHolder::Right);
+        });
+    } else if (id == ActionId::FocusUp) {
+        connect(action, &QAction::triggered, [this]() {
+            m_tabWidget->terminalHolder()->focusTerminal(TermWidgetHolder::Up);
+        });
+    } else if (id == ActionId::FocusDown) {
+        connect(action, &QAction::triggered, [this]() {
+            m_tabWidget->terminalHolder()->focusTerminal(TermWidgetHolder::Down);
+        });
+    } else if (id == ActionId::Copy) {
+        connect(action, &QAction::triggered, [this]() {
+            currentTerminal()->copyClipboard();
+        });
+    } else if (id == ActionId::Paste) {
+        connect(action, &QAction::triggered, [this]() {
+            currentTerminal()->pasteClipboard();
+        });
+    } else if (id == ActionId::PasteSelection) {
+        connect(action, &QAction::triggered, [this]() {
+            currentTerminal()->pasteSelection();
+        });
+    } else if (id == ActionId::Clear) {
+        connect(action, &QAction::triggered, [this]() {
+            currentTerminal()->clear();
+        });
+    } else if (id == ActionId::Find) {
+        connect(action, &QAction::triggered, [this]() {
+            currentTerminal()->toggleShowSearchBar();
+        });
+    } else if (id == ActionId::ZoomIn) {
+        connect(action, &QAction::triggered, [this]() {
+            currentTerminal()->zoomIn();
+        });
+    } else if (id == ActionId::ZoomOut) {
+        connect(action, &QAction::triggered, [this]() {
+            currentTerminal()->zoomOut();
+        });
+    } else if (id == ActionId::ZoomReset) {
+        connect(action, &QAction::triggered, [this]() {
+            currentTerminal()->zoomReset();
+        });
+    } else {
+        // Not handled by windows (e.g. the global drop-down shortcut)
+        return action;
+    }
 
-    action = m_actionManager->action(ActionId::PasteSelection);
-    connect(action, &QAction::triggered, [this]() {
-        currentTerminal()->pasteSelection();
-    });
-    addAction(action);
-    menu->addAction(action);
+    // The shortcut is only shown in menus, WindowShortcuts handles the key
+    action->setShortcutContext(Qt::WidgetShortcut);
+    return action;
+}
 
+void MainWindow::setupFileMenu(QMenu *menu)
+{
+    menu->addAction(windowAction(ActionId::NewTab));
+    menu->addAction(windowAction(ActionId::CloseTab));
     menu->addSeparator();
-
-    action = m_actionManager->action(ActionId::Clear);
-    connect(action, &QAction::triggered, [this]() {
-        currentTerminal()->clear();
-    });
-    addAction(action);
-    menu->addAction(action);
-
+    menu->addAction(windowAction(ActionId::NewWindow));
+    menu->addAction(windowAction(ActionId::CloseWindow));
     menu->addSeparator();
+    menu->addAction(windowAction(ActionId::Exit));
+}
 
-    action = m_actionManager->action(ActionId::Find);
-    connect(action, &QAction::triggered, [this]() {
-        currentTerminal()->toggleShowSearchBar();
-    });
-    addAction(action);
-    menu->addAction(action);
-
+void MainWindow::setupEditMenu(QMenu *menu)
+{
+    menu->addAction(windowAction(ActionId::Copy));
+    menu->addAction(windowAction(ActionId::Paste));
+    menu->addAction(windowAction(ActionId::PasteSelection));
     menu->addSeparator();
-
-    action = m_actionManager->action(ActionId::Preferences);
-    connect(action, &QAction::triggered, this, &MainWindow::showPreferencesDialog);
-    addAction(action);
-    menu->addAction(action);
-
-    menuBar()->addMenu(menu);
+    menu->addAction(windowAction(ActionId::Clear));
+    menu->addSeparator();
+    menu->addAction(windowAction(ActionId::Find));
+    menu->addSeparator();
+    menu->addAction(windowAction(ActionId::Preferences));
 }
 
-void MainWindow::setupViewMenu()
+void MainWindow::setupViewMenu(QMenu *menu)
 {
-    QMenu *menu = new QMenu(tr("&View"), menuBar());
-
-    QAction *action;
-    action = m_actionManager->action(ActionId::ShowMenu);
-    action->setCheckable(true);
-    action->setChecked(m_preferences->menuVisible);
-    connect(action, &QAction::triggered, this, &MainWindow::toggleMenuBar);
-    addAction(action);
-    menu->addAction(action);
-
-    action = m_actionManager->action(ActionId::ShowTabs);
-    action->setCheckable(true);
-    action->setChecked(!m_preferences->hideTabBar);
-    connect(action, &QAction::triggered, this, &MainWindow::toggleTabBar);
-    addAction(action);
-    menu->addAction(action);
+    menu->addAction(windowAction(ActionId::ShowMenu));
+    menu->addAction(windowAction(ActionId::ShowTabs));
+    menu->addAction(windowAction(ActionId::ShowResourceMonitor));
 
     menu->addSeparator();
 
@@ -242,116 +347,180 @@ void MainWindow::setupViewMenu()
     scrollBarPositionMenu->addActions(scrollBarPosition->actions());
 
     menu->addMenu(scrollBarPositionMenu);
-
-    menuBar()->addMenu(menu);
 }
 
-void MainWindow::setupHelpMenu()
+void MainWindow::setupHelpMenu(QMenu *menu)
 {
-    QMenu *menu = new QMenu(tr("&Help"), menuBar());
-
-    QAction *action;
-    action = m_actionManager->action(ActionId::About);
-    connect(action, &QAction::triggered, this, &MainWindow::showAboutMessageBox);
-    addAction(action);
-    menu->addAction(action);
-
-    action = m_actionManager->action(ActionId::AboutQt);
-    connect(action, &QAction::triggered, qApp, &QApplication::aboutQt);
-    addAction(action);
-    menu->addAction(action);
-
-    menuBar()->addMenu(menu);
+    menu->addAction(windowAction(ActionId::ToggleTracing));
+    menu->addAction(windowAction(ActionId::ShowEventLoopLatency));
+    menu->addSeparator();
+    menu->addAction(windowAction(ActionId::About));
+    menu->addAction(windowAction(ActionId::AboutQt));
 }
 
 void MainWindow::setupContextMenu()
 {
-    m_contextMenu = new QMenu(this);
+    // Before finishStartup() there are no actions, an empty menu is simply not shown
+    if (!m_contextMenu->isEmpty() || ActionManager::registry().isEmpty())
+        return;
 
-    m_contextMenu->addAction(m_actionManager->action(ActionId::Copy));
-    m_contextMenu->addAction(m_actionManager->action(ActionId::Paste));
-    m_contextMenu->addAction(m_actionManager->action(ActionId::PasteSelection));
+    m_contextMenu->addAction(windowAction(ActionId::Copy));
+    m_contextMenu->addAction(windowAction(ActionId::Paste));
+    m_contextMenu->addAction(windowAction(ActionId::PasteSelection));
     m_contextMenu->addSeparator();
-    m_contextMenu->addAction(m_actionManager->action(ActionId::Clear));
+    m_contextMenu->addAction(windowAction(ActionId::Clear));
     m_contextMenu->addSeparator();
 
-    QMenu *zoomMenu = new QMenu(tr("&Zoom"), m_contextMenu);
-
     /// TODO: Move to View Menu
-    QAction *action;
-    action = m_actionManager->action(ActionId::ZoomIn);
-    connect(action, &QAction::triggered, [this]() {
-        currentTerminal()->zoomIn();
-    });
-    addAction(action);
-    zoomMenu->addAction(action);
-
-    action = m_actionManager->action(ActionId::ZoomOut);
-    connect(action, &QAction::triggered, [this]() {
-        currentTerminal()->zoomOut();
-    });
-    addAction(action);
-    zoomMenu->addAction(action);
-
+    QMenu *zoomMenu = new QMenu(tr("&Zoom"), m_contextMenu);
+    zoomMenu->addAction(windowAction(ActionId::ZoomIn));
+    zoomMenu->addAction(windowAction(ActionId::ZoomOut));
     zoomMenu->addSeparator();
-
-    action = m_actionManager->action(ActionId::ZoomReset);
-    connect(action, &QAction::triggered, [this]() {
-        currentTerminal()->zoomReset();
-    });
-    addAction(action);
-    zoomMenu->addAction(action);
-
+    zoomMenu->addAction(windowAction(ActionId::ZoomReset));
     m_contextMenu->addMenu(zoomMenu);
 
     m_contextMenu->addSeparator();
+    m_contextMenu->addAction(windowAction(ActionId::SplitHorizontally));
+    m_contextMenu->addAction(windowAction(ActionId::SplitVertically));
+    m_contextMenu->addAction(windowAction(ActionId::SplitGrid));
 
-    action = m_actionManager->action(ActionId::SplitHorizontally);
-    connect(action, &QAction::triggered, m_tabWidget, &TabWidget::splitHorizontally);
-    addAction(action);
-    m_contextMenu->addAction(action);
-
-    action = m_actionManager->action(ActionId::SplitVertically);
-    connect(action, &QAction::triggered, m_tabWidget, &TabWidget::splitVertically);
-    addAction(action);
-    m_contextMenu->addAction(action);
+    QMenu *focusMenu = new QMenu(tr("&Focus"), m_contextMenu);
+    focusMenu->addAction(windowAction(ActionId::FocusLeft));
+    focusMenu->addAction(windowAction(ActionId::FocusRight));
+    focusMenu->addAction(windowAction(ActionId::FocusUp));
+    focusMenu->addAction(windowAction(ActionId::FocusDown));
+    m_contextMenu->addMenu(focusMenu);
 
     m_contextMenu->addSeparator();
-
-    action = m_actionManager->action(ActionId::CloseTerminal);
-    connect(action, &QAction::triggered, m_tabWidget, &TabWidget::splitCollapse);
-    addAction(action);
-    m_contextMenu->addAction(action);
-
-    m_tabWidget->setContextMenu(m_contextMenu);
-}
-
-void MainWindow::setupWindowActions()
-{
-    QAction *action;
-    action = m_actionManager->action(ActionId::NextTab);
-    connect(action, &QAction::triggered, m_tabWidget, &TabWidget::switchToRight);
-    addAction(action);
-
-    action = m_actionManager->action(ActionId::PreviousTab);
-    connect(action, &QAction::triggered, m_tabWidget, &TabWidget::switchToLeft);
-    addAction(action);
+    m_contextMenu->addAction(windowAction(ActionId::CloseTerminal));
 }
 
 void MainWindow::toggleTabBar()
 {
-    const bool newVisible = m_actionManager->action(ActionId::ShowTabs)->isChecked();
+    const bool newVisible = windowAction(ActionId::ShowTabs)->isChecked();
     m_tabWidget->tabBar()->setVisible(newVisible);
     m_preferences->hideTabBar = !newVisible;
 }
 
 void MainWindow::toggleMenuBar()
 {
-    const bool newVisible = m_actionManager->action(ActionId::ShowMenu)->isChecked();
+    const bool newVisible = windowAction(ActionId::ShowMenu)->isChecked();
     menuBar()->setVisible(newVisible);
     m_preferences->menuVisible = newVisible;
 }
 
+void MainWindow::splitGrid()
+{
+    bool ok = false;
+    const QString text = QInputDialog::getText(this, tr("Split into Grid"),
+                                               tr("Rows x columns:"), QLineEdit::Normal,
+                                               QStringLiteral("2x2"), &ok);
+    if (!ok)
+        return;
+
+    const QSize grid = TermWidgetHolder::parseGridSize(text);
+    if (!grid.isValid()) {
+        QMessageBox::warning(this, tr("Split into Grid"), tr("Invalid grid size: %1").arg(text));
+        return;
+    }
+
+    TermWidgetHolder *holder = m_tabWidget->terminalHolder();
+    holder->createGrid(holder->currentTerminal(), grid.height(), grid.width());
+}
+
+void MainWindow::toggleResourceMonitor(bool visible)
+{
+    if (!m_resourceMonitor) {
+        if (!visible)
+            return;
+
+        m_resourceMonitor = new ResourceMonitor(m_tabWidget, this);
+        addDockWidget(Qt::BottomDockWidgetArea, m_resourceMonitor);
+        connect(m_resourceMonitor, &ResourceMonitor::visibilityChanged, [this](bool visible) {
+            windowAction(ActionId::ShowResourceMonitor)->setChecked(visible);
+        });
+    }
+
+    m_resourceMonitor->setVisible(visible);
+}
+
+void MainWindow::toggleTracing()
+{
+    // The action of this window may be out of date, the tracer has the actual state
+    if (Tracer::isEnabled()) {
+        const QString fileName = Tracer::stop();
+        windowAction(ActionId::ToggleTracing)->setChecked(false);
+        if (!fileName.isEmpty()) {
+            QMessageBox::information(this, tr("Trace Recorded"),
+                                     tr("The trace has been written to %1").arg(fileName));
+        }
+        return;
+    }
+
+    const QString fileName = QDir::temp().absoluteFilePath(
+                QStringLiteral("quickterminal-%1-%2.json")
+                .arg(QCoreApplication::applicationPid())
+                .arg(QDateTime::currentDateTime().toString(QStringLiteral("yyyyMMdd-hhmmss"))));
+    Tracer::start(fileName);
+    windowAction(ActionId::ToggleTracing)->setChecked(Tracer::isEnabled());
+}
+
+void MainWindow::showEventLoopLatency()
+{
+    StallDetector *detector = StallDetector::instance();
+    if (!detector->isRunning() && !InputLatency::isEnabled()) {
+        QMessageBox::information(this, tr("Event Loop Latency"),
+                                 tr("The stall detector and the input latency probe are "
+                                    "disabled. Set StallDetector=true or InputLatencyProbe=true "
+                                    "in the [Debug] section of the configuration to enable them."));
+        return;
+    }
+
+    QString text;
+
+    if (detector->isRunning()) {
+        const QVector<int> histogram = detector->histogram();
+        int total = 0;
+        foreach (int count, histogram)
+            total += count;
+
+        text += tr("<p>%1 stalls longer than %2 ms, logged to %3</p>")
+                .arg(detector->stallCount()).arg(detector->threshold())
+                .arg(detector->logFileName().toHtmlEscaped());
+        text += QStringLiteral("<table>");
+        for (int i = 0; i < histogram.size(); ++i) {
+            const int limit = StallDetector::bucketLimit(i);
+            const QString label = limit < 0
+                    ? tr("&ge; %1 ms").arg(StallDetector::bucketLimit(i - 1))
+                    : tr("&lt; %1 ms").arg(limit);
+            text += QStringLiteral("<tr><td>%1</td><td align=\"right\">%2</td>"
+                                   "<td align=\"right\">%3%</td></tr>")
+                    .arg(label).arg(histogram.at(i))
+                    .arg(total ? 100.0 * histogram.at(i) / total : 0.0, 0, 'f', 1);
+        }
+        text += QStringLiteral("</table>");
+    }
+
+    if (InputLatency::isEnabled()) {
+        text += tr("<p>Keypress to paint latency</p>");
+        text += tr("<table><tr><th></th><th>Samples</th><th>p50</th><th>p99</th><th>Max</th></tr>");
+        for (int busy = 0; busy < 2; ++busy) {
+            const InputLatency::Summary summary = InputLatency::summary(busy);
+            text += QStringLiteral("<tr><td>%1</td><td align=\"right\">%2</td>"
+                                   "<td align=\"right\">%3 ms</td><td align=\"right\">%4 ms</td>"
+                                   "<td align=\"right\">%5 ms</td></tr>")
+                    .arg(busy ? tr("Output in other terminals") : tr("Idle"))
+                    .arg(summary.count)
+                    .arg(summary.p50 / 1000.0, 0, 'f', 1)
+                    .arg(summary.p99 / 1000.0, 0, 'f', 1)
+                    .arg(summary.max / 1000.0, 0, 'f', 1);
+        }
+        text += QStringLiteral("</table>");
+    }
+
+    QMessageBox::information(this, tr("Event Loop Latency"), text);
+}
+
 void MainWindow::showAboutMessageBox()
 {
     QMessageBox::about(this, QString("About %1").arg(qApp->applicationName()),
@@ -453,6 +622,19 @@ bool MainWindow::event(QEvent *event)
     return QMainWindow::event(event);
 }
 
+void MainWindow::changeEvent(QEvent *event)
+{
+    QMainWindow::changeEvent(event);
+
+    // Minimizing does not hide the terminals, tell them that nobody can see them
+    if (event->type() == QEvent::WindowStateChange) {
+        for (int i = 0; i < m_tabWidget->count(); ++i) {
+            foreach (TerminalWidget *terminal, m_tabWidget->terminalHolder(i)->terminals())
+                terminal->updateSuspended();
+        }
+    }
+}
+
 TerminalWidget *MainWindow::currentTerminal() const
 {
     return m_tabWidget->terminalHolder()->currentTerminal();
@@ -23,11 +23,13 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QSet>
 
 class QActionGroup;
 class QToolButton;
 
 class ActionManager;
+class ResourceMonitor;
 class Preferences;
 class TabWidget;
 class TerminalWidget;
@@ -40,6 +42,14 @@ public:
                         QWidget *parent = nullptr, Qt::WindowFlags f = 0);
 
     void enableDropMode();
+    void setupMenus();
+
+    void addTab(const QString &workingDir, const QString &command);
+
+    static bool handlesAction(const QString &id);
+    void triggerAction(const QString &id);
+
+    TabWidget *tabWidget() const;
 
 signals:
     void newWindow();
@@ -48,36 +58,47 @@ signals:
 protected:
     void closeEvent(QCloseEvent *event) override;
     bool event(QEvent *event);
+    void changeEvent(QEvent *event) override;
 
 private slots:
     void preferencesChanged();
     void showAboutMessageBox();
+    void toggleTracing();
+    void showEventLoopLatency();
     void showPreferencesDialog();
 
     void toggleTabBar();
     void toggleMenuBar();
+    void toggleResourceMonitor(bool visible);
+    void splitGrid();
 
-    void showHide();
     void setKeepOpen(bool value);
 
+public slots:
+    void showHide();
+
 private:
     inline TerminalWidget *currentTerminal() const;
 
-    void setupFileMenu();
-    void setupEditMenu();
-    void setupViewMenu();
-    void setupHelpMenu();
+    void setupMenu(const QString &title, void (MainWindow::*setup)(QMenu *));
+    void setupFileMenu(QMenu *menu);
+    void setupEditMenu(QMenu *menu);
+    void setupViewMenu(QMenu *menu);
+    void setupHelpMenu(QMenu *menu);
     void setupContextMenu();
-    void setupWindowActions();
+
+    QAction *windowAction(const QString &id);
 
     void realign();
 
     Preferences * const m_preferences = nullptr;
     ActionManager *m_actionManager = nullptr;
+    QSet<QString> m_windowActions;
 
     QMenu *m_contextMenu = nullptr;
 
     TabWidget *m_tabWidget = nullptr;
+    ResourceMonitor *m_resourceMonitor = nullptr;
 
     QToolButton *m_dropDownLockButton = nullptr;
     bool m_dropDownMode = false;
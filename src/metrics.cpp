@@ -0,0 +1,109 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#include "metrics.h"
+
+namespace {
+// Upper bounds of the spawn latency buckets, in microseconds
+const qint64 SpawnLatencyLimits[] = { 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000 };
+const int SpawnLatencyBucketCount = sizeof(SpawnLatencyLimits) / sizeof(SpawnLatencyLimits[0]);
+
+// Upper bounds of the PTY read size buckets, in bytes
+const qint64 ReadSizeLimits[] = { 64, 256, 1024, 4096, 16384, 65536, 262144 };
+const int ReadSizeBucketCount = sizeof(ReadSizeLimits) / sizeof(ReadSizeLimits[0]);
+}
+
+QAtomicInteger<quint64> Metrics::m_counters[Metrics::CounterCount];
+QAtomicInteger<qint64> Metrics::m_spawnLatencySum;
+QAtomicInteger<quint64> Metrics::m_spawnLatencyBuckets[SpawnLatencyBucketCount + 1];
+QAtomicInteger<qint64> Metrics::m_readSizeSum;
+QAtomicInteger<quint64> Metrics::m_readSizeBuckets[ReadSizeBucketCount + 1];
+
+void Metrics::add(Counter counter, quint64 value)
+{
+    m_counters[counter].fetchAndAddRelaxed(value);
+}
+
+quint64 Metrics::value(Counter counter)
+{
+    return m_counters[counter].load();
+}
+
+void Metrics::addSpawnLatency(qint64 usecs)
+{
+    int bucket = 0;
+    while (bucket < SpawnLatencyBucketCount && usecs > SpawnLatencyLimits[bucket])
+        ++bucket;
+
+    m_spawnLatencyBuckets[bucket].fetchAndAddRelaxed(1);
+    m_spawnLatencySum.fetchAndAddRelaxed(usecs);
+}
+
+qint64 Metrics::spawnLatencySum()
+{
+    return m_spawnLatencySum.load();
+}
+
+/// Number of spawns in \a bucket; the last bucket holds those slower than all limits
+quint64 Metrics::spawnLatencyCount(int bucket)
+{
+    return m_spawnLatencyBuckets[bucket].load();
+}
+
+int Metrics::spawnLatencyBucketCount()
+{
+    return SpawnLatencyBucketCount + 1;
+}
+
+qint64 Metrics::spawnLatencyBucketLimit(int bucket)
+{
+    return bucket < SpawnLatencyBucketCount ? SpawnLatencyLimits[bucket] : -1;
+}
+
+void Metrics::addReadSize(qint64 bytes)
+{
+    int bucket = 0;
+    while (bucket < ReadSizeBucketCount && bytes > ReadSizeLimits[bucket])
+        ++bucket;
+
+    m_readSizeBuckets[bucket].fetchAndAddRelaxed(1);
+    m_readSizeSum.fetchAndAddRelaxed(bytes);
+}
+
+qint64 Metrics::readSizeSum()
+{
+    return m_readSizeSum.load();
+}
+
+/// Number of reads in \a bucket; the last bucket holds those larger than all limits
+quint64 Metrics::readSizeCount(int bucket)
+{
+    return m_readSizeBuckets[bucket].load();
+}
+
+int Metrics::readSizeBucketCount()
+{
+    return ReadSizeBucketCount + 1;
+}
+
+qint64 Metrics::readSizeBucketLimit(int bucket)
+{
+    return bucket < ReadSizeBucketCount ? ReadSizeLimits[bucket] : -1;
+}
@@ -0,0 +1,67 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QAtomicInteger>
+
+/*! \brief Process-wide counters for the metrics export.
+
+Counters only ever grow and are cheap enough to be updated on every event.
+*/
+class Metrics
+{
+public:
+    enum Counter {
+        PtyBytesRead,
+        PtyLines,
+        Paints,
+        OutputProcessingTime, // us
+        ReactorWakeups,
+        CounterCount
+    };
+
+    static void add(Counter counter, quint64 value = 1);
+    static quint64 value(Counter counter);
+
+    static void addSpawnLatency(qint64 usecs);
+    static qint64 spawnLatencySum();
+    static quint64 spawnLatencyCount(int bucket);
+
+    static int spawnLatencyBucketCount();
+    static qint64 spawnLatencyBucketLimit(int bucket);
+
+    static void addReadSize(qint64 bytes);
+    static qint64 readSizeSum();
+    static quint64 readSizeCount(int bucket);
+
+    static int readSizeBucketCount();
+    static qint64 readSizeBucketLimit(int bucket);
+
+private:
+    static QAtomicInteger<quint64> m_counters[CounterCount];
+    static QAtomicInteger<qint64> m_spawnLatencySum;
+    static QAtomicInteger<quint64> m_spawnLatencyBuckets[];
+    static QAtomicInteger<qint64> m_readSizeSum;
+    static QAtomicInteger<quint64> m_readSizeBuckets[];
+};
+
+#endif // METRICS_H
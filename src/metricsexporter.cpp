@@ -0,0 +1,205 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#include "metricsexporter.h"
+
+#include "mainwindow.h"
+#include "metrics.h"
+#include "metricswriter.h"
+#include "stalldetector.h"
+#include "tabwidget.h"
+#include "termwidgetholder.h"
+
+#include <QApplication>
+#include <QDir>
+#include <QStandardPaths>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+
+namespace {
+void writeMetric(QTextStream &out, const char *name, const char *type, const char *help,
+                 qint64 value)
+{
+    out << "# HELP quickterminal_" << name << ' ' << help << '\n'
+        << "# TYPE quickterminal_" << name << ' ' << type << '\n'
+        << "quickterminal_" << name << ' ' << value << '\n';
+}
+
+/// Writes a histogram, \a scale converts the recorded values to the exported unit
+void writeHistogram(QTextStream &out, const char *name, const char *help,
+                    int bucketCount, quint64 (*count)(int), qint64 (*limit)(int), qint64 sum,
+                    double scale)
+{
+    out << "# HELP quickterminal_" << name << ' ' << help << '\n'
+        << "# TYPE quickterminal_" << name << " histogram\n";
+    quint64 total = 0;
+    for (int i = 0; i < bucketCount; ++i) {
+        total += count(i);
+        out << "quickterminal_" << name << "_bucket{le=\""
+            << (limit(i) < 0 ? QStringLiteral("+Inf") : QString::number(limit(i) / scale))
+            << "\"} " << total << '\n';
+    }
+    out << "quickterminal_" << name << "_sum " << sum / scale << '\n'
+        << "quickterminal_" << name << "_count " << total << '\n';
+}
+}
+
+MetricsExporter::MetricsExporter(QObject *parent) :
+    QObject(parent),
+    m_timer(new QTimer(this))
+{
+    connect(m_timer, &QTimer::timeout, this, &MetricsExporter::collect);
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    stop();
+}
+
+bool MetricsExporter::isRunning() const
+{
+    return m_thread;
+}
+
+void MetricsExporter::start(Mode mode, const QString &path, int interval)
+{
+    if (m_thread || mode == Disabled)
+        return;
+
+    m_mode = mode;
+    m_path = path.isEmpty() ? defaultPath(mode) : path;
+
+    m_thread = new QThread(this);
+    m_writer = new MetricsWriter();
+    m_writer->moveToThread(m_thread);
+    connect(m_thread, &QThread::finished, m_writer, &QObject::deleteLater);
+    m_thread->start(QThread::LowPriority);
+
+    QMetaObject::invokeMethod(m_writer, mode == File ? "writeToFile" : "listen",
+                              Qt::QueuedConnection, Q_ARG(QString, m_path));
+
+    m_timer->start(interval * 1000);
+    collect();
+}
+
+void MetricsExporter::stop()
+{
+    if (!m_thread)
+        return;
+
+    m_timer->stop();
+
+    m_thread->quit();
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+    m_writer = nullptr;
+
+    m_mode = Disabled;
+}
+
+MetricsExporter::Mode MetricsExporter::mode() const
+{
+    return m_mode;
+}
+
+QString MetricsExporter::path() const
+{
+    return m_path;
+}
+
+int MetricsExporter::interval() const
+{
+    return m_timer->interval() / 1000;
+}
+
+QString MetricsExporter::defaultPath(Mode mode)
+{
+    QString path = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (path.isEmpty())
+        path = QDir::tempPath();
+    return QDir(path).absoluteFilePath(mode == Socket ? QStringLiteral("quickterminal-metrics")
+                                                      : QStringLiteral("quickterminal.prom"));
+}
+
+void MetricsExporter::collect()
+{
+    int windows = 0;
+    int tabs = 0;
+    int panes = 0;
+    qint64 scrollbackLines = 0;
+    qint64 scrollbackBytes = 0;
+
+    foreach (QWidget *widget, QApplication::topLevelWidgets()) {
+        MainWindow *window = qobject_cast<MainWindow *>(widget);
+        if (!window)
+            continue;
+
+        TabWidget *tabWidget = window->tabWidget();
+        ++windows;
+        tabs += tabWidget->count();
+
+        for (int i = 0; i < tabWidget->count(); ++i) {
+            foreach (TerminalWidget *terminal, tabWidget->terminalHolder(i)->terminals()) {
+                ++panes;
+                scrollbackLines += terminal->historyLinesCount();
+                scrollbackBytes += terminal->scrollbackSize();
+            }
+        }
+    }
+
+    QByteArray text;
+    QTextStream out(&text);
+
+    writeMetric(out, "windows", "gauge", "Number of open windows.", windows);
+    writeMetric(out, "tabs", "gauge", "Number of open tabs.", tabs);
+    writeMetric(out, "panes", "gauge", "Number of terminals in all tabs.", panes);
+    writeMetric(out, "scrollback_lines", "gauge", "Lines kept in the history of all terminals.",
+                scrollbackLines);
+    writeMetric(out, "scrollback_bytes", "gauge",
+                "Estimated memory used by the history of all terminals.", scrollbackBytes);
+    writeMetric(out, "pty_read_bytes_total", "counter", "Bytes read from terminal processes.",
+                Metrics::value(Metrics::PtyBytesRead));
+    writeMetric(out, "pty_lines_total", "counter", "Lines read from terminal processes.",
+                Metrics::value(Metrics::PtyLines));
+    writeMetric(out, "paints_total", "counter", "Terminal display repaints.",
+                Metrics::value(Metrics::Paints));
+    writeMetric(out, "output_processing_microseconds_total", "counter",
+                "Time spent writing process output to the teletype PTYs of the terminals, "
+                "parsing it in qtermwidget is not included.",
+                Metrics::value(Metrics::OutputProcessingTime));
+    writeMetric(out, "stalls_total", "counter", "Event loop stalls over the stall threshold.",
+                StallDetector::instance()->stallCount());
+
+    writeMetric(out, "reactor_wakeups_total", "counter",
+                "Wakeups of the thread reading terminal processes.",
+                Metrics::value(Metrics::ReactorWakeups));
+
+    writeHistogram(out, "shell_spawn_seconds", "Time taken to start a shell.",
+                   Metrics::spawnLatencyBucketCount(), &Metrics::spawnLatencyCount,
+                   &Metrics::spawnLatencyBucketLimit, Metrics::spawnLatencySum(), 1e6);
+    writeHistogram(out, "pty_read_size_bytes", "Size of reads from terminal processes.",
+                   Metrics::readSizeBucketCount(), &Metrics::readSizeCount,
+                   &Metrics::readSizeBucketLimit, Metrics::readSizeSum(), 1);
+    out.flush();
+
+    QMetaObject::invokeMethod(m_writer, "write", Qt::QueuedConnection, Q_ARG(QByteArray, text));
+}
@@ -0,0 +1,72 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#ifndef METRICSEXPORTER_H
+#define METRICSEXPORTER_H
+
+#include <QObject>
+
+class QThread;
+class QTimer;
+
+class MetricsWriter;
+
+/*! \brief Periodic export of application metrics in Prometheus text format.
+
+Metrics are collected on the GUI thread, which only takes a walk over the
+open windows. The text is handed to a MetricsWriter in its own thread, so a
+slow disk or client never blocks the GUI.
+*/
+class MetricsExporter : public QObject
+{
+    Q_OBJECT
+public:
+    enum Mode {
+        Disabled,
+        File,
+        Socket
+    };
+
+    explicit MetricsExporter(QObject *parent = nullptr);
+    ~MetricsExporter() override;
+
+    bool isRunning() const;
+    void start(Mode mode, const QString &path, int interval);
+    void stop();
+
+    Mode mode() const;
+    QString path() const;
+    int interval() const;
+
+    static QString defaultPath(Mode mode);
+
+private slots:
+    void collect();
+
+private:
+    QThread *m_thread = nullptr;
+    MetricsWriter *m_writer = nullptr;
+    QTimer *m_timer = nullptr;
+
+    Mode m_mode = Disabled;
+    QString m_path;
+};
+
+#endif // METRICSEXPORTER_H
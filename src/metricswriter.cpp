@@ -0,0 +1,73 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#include "metricswriter.h"
+
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QSaveFile>
+
+MetricsWriter::MetricsWriter(QObject *parent) :
+    QObject(parent)
+{
+}
+
+void MetricsWriter::writeToFile(const QString &fileName)
+{
+    m_fileName = fileName;
+}
+
+void MetricsWriter::listen(const QString &name)
+{
+    m_server = new QLocalServer(this);
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(m_server, &QLocalServer::newConnection, this, &MetricsWriter::acceptConnection);
+
+    QLocalServer::removeServer(name);
+    if (!m_server->listen(name)) {
+        qWarning("Cannot export metrics on '%s': %s", qPrintable(name),
+                 qPrintable(m_server->errorString()));
+    }
+}
+
+void MetricsWriter::write(const QByteArray &text)
+{
+    m_text = text;
+
+    if (m_fileName.isEmpty())
+        return;
+
+    // Scrapers must never see a partially written file
+    QSaveFile file(m_fileName);
+    if (!file.open(QIODevice::WriteOnly) || file.write(m_text) != m_text.size()
+            || !file.commit()) {
+        qWarning("Cannot write metrics to '%s': %s", qPrintable(m_fileName),
+                 qPrintable(file.errorString()));
+    }
+}
+
+void MetricsWriter::acceptConnection()
+{
+    while (QLocalSocket *socket = m_server->nextPendingConnection()) {
+        connect(socket, &QLocalSocket::disconnected, socket, &QLocalSocket::deleteLater);
+        socket->write(m_text);
+        socket->disconnectFromServer();
+    }
+}
@@ -0,0 +1,53 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#ifndef METRICSWRITER_H
+#define METRICSWRITER_H
+
+#include <QObject>
+
+class QLocalServer;
+
+/*! \brief Publishes metrics text from a worker thread.
+
+The text either replaces a file atomically, or is served to every client
+connecting to a local socket.
+*/
+class MetricsWriter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MetricsWriter(QObject *parent = nullptr);
+
+public slots:
+    void writeToFile(const QString &fileName);
+    void listen(const QString &name);
+    void write(const QByteArray &text);
+
+private slots:
+    void acceptConnection();
+
+private:
+    QString m_fileName;
+    QLocalServer *m_server = nullptr;
+    QByteArray m_text;
+};
+
+#endif // METRICSWRITER_H
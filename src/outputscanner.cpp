@@ -0,0 +1,293 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#include "outputscanner.h"
+
+#ifdef Q_PROCESSOR_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+const char Escape = 0x1b;
+const char Newline = '\n';
+
+// Escape sequences that start further back than this are not held back
+const int MaxSequenceLength = 256;
+
+bool isControl(char c)
+{
+    return static_cast<uchar>(c) < 0x20 || c == 0x7f;
+}
+
+int findControlScalar(const char *data, int length)
+{
+    for (int i = 0; i < length; ++i) {
+        if (isControl(data[i]))
+            return i;
+    }
+    return length;
+}
+
+int countLinesScalar(const char *data, int length)
+{
+    int lines = 0;
+    for (int i = 0; i < length; ++i)
+        lines += data[i] == Newline;
+    return lines;
+}
+
+#ifdef Q_PROCESSOR_X86
+__attribute__((target("sse2")))
+int findControlSse2(const char *data, int length)
+{
+    const __m128i controlMax = _mm_set1_epi8(0x1f);
+    const __m128i del = _mm_set1_epi8(0x7f);
+
+    int i = 0;
+    for (; i + 16 <= length; i += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        // Unsigned bytes up to 0x1f equal their minimum with 0x1f
+        const __m128i control = _mm_or_si128(
+                    _mm_cmpeq_epi8(_mm_min_epu8(bytes, controlMax), bytes),
+                    _mm_cmpeq_epi8(bytes, del));
+        const int mask = _mm_movemask_epi8(control);
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+    return i + findControlScalar(data + i, length - i);
+}
+
+__attribute__((target("sse2")))
+int countLinesSse2(const char *data, int length)
+{
+    const __m128i newline = _mm_set1_epi8(Newline);
+
+    int lines = 0;
+    int i = 0;
+    for (; i + 16 <= length; i += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        lines += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline)));
+    }
+    return lines + countLinesScalar(data + i, length - i);
+}
+
+__attribute__((target("avx2")))
+int findControlAvx2(const char *data, int length)
+{
+    const __m256i controlMax = _mm256_set1_epi8(0x1f);
+    const __m256i del = _mm256_set1_epi8(0x7f);
+
+    int i = 0;
+    for (; i + 32 <= length; i += 32) {
+        const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        const __m256i control = _mm256_or_si256(
+                    _mm256_cmpeq_epi8(_mm256_min_epu8(bytes, controlMax), bytes),
+                    _mm256_cmpeq_epi8(bytes, del));
+        const unsigned mask = _mm256_movemask_epi8(control);
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+    return i + findControlSse2(data + i, length - i);
+}
+
+__attribute__((target("avx2")))
+int countLinesAvx2(const char *data, int length)
+{
+    const __m256i newline = _mm256_set1_epi8(Newline);
+
+    int lines = 0;
+    int i = 0;
+    for (; i + 32 <= length; i += 32) {
+        const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        lines += __builtin_popcount(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, newline)));
+    }
+    return lines + countLinesSse2(data + i, length - i);
+}
+#endif
+
+/// Returns true if the escape sequence at the start of \a data continues past its end
+bool isIncompleteSequence(const char *data, int length)
+{
+    if (length < 2)
+        return true;
+
+    switch (data[1]) {
+    case '[':
+        // CSI: parameter and intermediate bytes up to a final byte
+        for (int i = 2; i < length; ++i) {
+            const uchar c = data[i];
+            if (c >= 0x40 && c <= 0x7e)
+                return false;
+            if (c < 0x20 || c > 0x3f)
+                return false;
+        }
+        return true;
+    case ']':
+    case 'P':
+    case '_':
+    case '^':
+        // String sequences end with BEL or ST
+        for (int i = 2; i < length; ++i) {
+            if (data[i] == '\a' || (data[i] == Escape && i + 1 < length && data[i + 1] == '\\'))
+                return false;
+        }
+        return true;
+    default:
+        // Character set selection and similar take one more byte
+        return length < 3 && (data[1] == '(' || data[1] == ')' || data[1] == '#');
+    }
+}
+
+/// Length of a UTF-8 sequence with lead byte \a c, 0 for continuation and invalid bytes
+int utf8SequenceLength(uchar c)
+{
+    if (c < 0x80)
+        return 1;
+    if (c >= 0xc2 && c <= 0xdf)
+        return 2;
+    if (c >= 0xe0 && c <= 0xef)
+        return 3;
+    if (c >= 0xf0 && c <= 0xf4)
+        return 4;
+    return 0;
+}
+}
+
+// Usable before initialize(), which must not race with scans on other threads
+OutputScanner::Implementation OutputScanner::m_implementation = OutputScanner::Scalar;
+int (*OutputScanner::m_findControl)(const char *, int) = findControlScalar;
+int (*OutputScanner::m_countLines)(const char *, int) = countLinesScalar;
+
+/// Selects the fastest supported implementation, call before any other thread scans output
+void OutputScanner::initialize()
+{
+    setImplementation(bestImplementation());
+}
+
+OutputScanner::Implementation OutputScanner::implementation()
+{
+    return m_implementation;
+}
+
+bool OutputScanner::setImplementation(Implementation implementation)
+{
+    if (!isSupported(implementation))
+        return false;
+
+    m_implementation = implementation;
+    switch (implementation) {
+#ifdef Q_PROCESSOR_X86
+    case Avx2:
+        m_findControl = findControlAvx2;
+        m_countLines = countLinesAvx2;
+        break;
+    case Sse2:
+        m_findControl = findControlSse2;
+        m_countLines = countLinesSse2;
+        break;
+#endif
+    default:
+        m_findControl = findControlScalar;
+        m_countLines = countLinesScalar;
+        break;
+    }
+    return true;
+}
+
+bool OutputScanner::isSupported(Implementation implementation)
+{
+    switch (implementation) {
+    case Scalar:
+        return true;
+#ifdef Q_PROCESSOR_X86
+    case Sse2:
+        return __builtin_cpu_supports("sse2");
+    case Avx2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+const char *OutputScanner::implementationName(Implementation implementation)
+{
+    switch (implementation) {
+    case Sse2:
+        return "sse2";
+    case Avx2:
+        return "avx2";
+    default:
+        return "scalar";
+    }
+}
+
+/// Returns the position of the first control character, or \a length if there is none
+int OutputScanner::findControl(const char *data, int length)
+{
+    return m_findControl(data, length);
+}
+
+int OutputScanner::countLines(const char *data, int length)
+{
+    return m_countLines(data, length);
+}
+
+/*!
+  Returns the length of the longest prefix of \a data that does not end inside an
+  escape sequence or a UTF-8 sequence, or \a length when there is no such prefix.
+  Cutting output there means that the terminal never has to keep a partial
+  sequence around until the next write.
+*/
+int OutputScanner::chunkBoundary(const char *data, int length)
+{
+    // The last escape sequence close to the end
+    const int windowStart = qMax(0, length - MaxSequenceLength);
+    int escape = -1;
+    for (int i = windowStart; i < length; ++i) {
+        i += findControl(data + i, length - i);
+        if (i < length && data[i] == Escape)
+            escape = i;
+    }
+
+    if (escape > 0 && isIncompleteSequence(data + escape, length - escape))
+        return escape;
+
+    // Back off over the continuation bytes of a split character
+    for (int i = length - 1; i >= qMax(0, length - 4); --i) {
+        const int sequenceLength = utf8SequenceLength(data[i]);
+        if (!sequenceLength)
+            continue;
+        if (i + sequenceLength > length && i > 0)
+            return i;
+        break;
+    }
+
+    return length;
+}
+
+OutputScanner::Implementation OutputScanner::bestImplementation()
+{
+    for (int i = ImplementationCount - 1; i > Scalar; --i) {
+        if (isSupported(static_cast<Implementation>(i)))
+            return static_cast<Implementation>(i);
+    }
+    return Scalar;
+}
@@ -0,0 +1,63 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#ifndef OUTPUTSCANNER_H
+#define OUTPUTSCANNER_H
+
+#include <QtGlobal>
+
+/*! \brief Vectorised scans over process output.
+
+Most output is long runs of printable text with an occasional control byte
+or escape sequence, which the SSE2 and AVX2 kernels skip 16 or 32 bytes at a
+time. The fastest implementation the CPU supports is picked by initialize()
+at startup, before threads that scan output exist; until then, and on other
+CPUs and architectures, the scalar one is used.
+*/
+class OutputScanner
+{
+public:
+    enum Implementation {
+        Scalar,
+        Sse2,
+        Avx2,
+        ImplementationCount
+    };
+
+    static void initialize();
+    static Implementation implementation();
+    static bool setImplementation(Implementation implementation);
+    static bool isSupported(Implementation implementation);
+    static const char *implementationName(Implementation implementation);
+
+    static int findControl(const char *data, int length);
+    static int countLines(const char *data, int length);
+
+    static int chunkBoundary(const char *data, int length);
+
+private:
+    static Implementation bestImplementation();
+
+    static Implementation m_implementation;
+    static int (*m_findControl)(const char *, int);
+    static int (*m_countLines)(const char *, int);
+};
+
+#endif // OUTPUTSCANNER_H
@@ -0,0 +1,114 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#include "outputscheduler.h"
+
+#include "ptyrelay.h"
+#include "tracer.h"
+
+#include <QCoreApplication>
+#include <QTimer>
+
+#include <algorithm>
+
+namespace {
+const qint64 PassBudget = 8000; // us
+const qint64 PriorityBudget[] = {
+    4000, // Focused
+    2000, // Visible
+    500 // Background
+};
+}
+
+OutputScheduler *OutputScheduler::m_instance = nullptr;
+
+OutputScheduler *OutputScheduler::instance()
+{
+    if (!m_instance)
+        m_instance = new OutputScheduler(qApp);
+    return m_instance;
+}
+
+OutputScheduler::OutputScheduler(QObject *parent) :
+    QObject(parent),
+    m_timer(new QTimer(this))
+{
+    m_timer->setSingleShot(true);
+    m_timer->setInterval(0);
+    connect(m_timer, &QTimer::timeout, this, &OutputScheduler::run);
+
+    m_clock.start();
+}
+
+OutputScheduler::~OutputScheduler()
+{
+    m_instance = nullptr;
+}
+
+void OutputScheduler::schedule(PtyRelay *relay)
+{
+    if (!m_queue.contains(relay) && !m_pass.contains(relay))
+        m_queue.append(relay);
+    m_timer->start();
+}
+
+void OutputScheduler::cancel(PtyRelay *relay)
+{
+    m_queue.removeOne(relay);
+    m_pass.removeOne(relay);
+}
+
+/// Time in microseconds
+qint64 OutputScheduler::now() const
+{
+    return m_clock.nsecsElapsed() / 1000;
+}
+
+void OutputScheduler::run()
+{
+    TRACE_SCOPE("OutputScheduler::run");
+
+    // Equal priorities keep their order, so relays that have just been processed,
+    // which are queued again at the end, take turns with the others
+    m_pass.swap(m_queue);
+    std::stable_sort(m_pass.begin(), m_pass.end(), [](PtyRelay *a, PtyRelay *b) {
+        return a->priority() < b->priority();
+    });
+
+    const qint64 passEnd = now() + PassBudget;
+
+    while (!m_pass.isEmpty()) {
+        // The focused terminal is never held back by the pass budget
+        PtyRelay *relay = m_pass.first();
+        if (relay->priority() != Focused && now() >= passEnd)
+            break;
+
+        m_pass.removeFirst();
+        if (relay->processOutput(now() + PriorityBudget[relay->priority()]))
+            m_queue.append(relay);
+    }
+
+    // Whatever did not fit into this pass goes first in the next one
+    m_queue = m_pass + m_queue;
+    m_pass.clear();
+
+    if (!m_queue.isEmpty())
+        m_timer->start();
+}
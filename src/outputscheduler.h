@@ -0,0 +1,73 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#ifndef OUTPUTSCHEDULER_H
+#define OUTPUTSCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+
+class QTimer;
+
+class PtyRelay;
+
+/*! \brief Shares the event loop between the output of all terminals.
+
+Relays with output to read are queued here instead of reading it right away.
+Each pass processes them in priority order, the focused terminal first, then
+the other visible ones and background terminals last, each within a time
+budget of its priority. Relays that still have output are processed again in
+the next pass, after the events that arrived in the meantime.
+*/
+class OutputScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    enum Priority {
+        Focused,
+        Visible,
+        Background
+    };
+
+    static OutputScheduler *instance();
+
+    void schedule(PtyRelay *relay);
+    void cancel(PtyRelay *relay);
+
+    qint64 now() const;
+
+private slots:
+    void run();
+
+private:
+    static OutputScheduler *m_instance;
+
+    explicit OutputScheduler(QObject *parent = nullptr);
+    Q_DISABLE_COPY(OutputScheduler)
+    ~OutputScheduler() override;
+
+    QTimer *m_timer = nullptr;
+    QElapsedTimer m_clock;
+    QList<PtyRelay *> m_queue;
+    QList<PtyRelay *> m_pass;
+};
+
+#endif // OUTPUTSCHEDULER_H
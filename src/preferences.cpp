@@ -20,6 +20,8 @@
 
 #include "preferences.h"
 
+#include "tracer.h"
+
 #include <QApplication>
 #include <QFontDatabase>
 #include <QSettings>
@@ -50,6 +52,8 @@ Preferences::~Preferences()
 
 void Preferences::load()
 {
+    TRACE_SCOPE("Preferences::load");
+
     guiStyle = m_settings->value(QStringLiteral("guiStyle"), QString()).toString();
     if (!guiStyle.isNull())
         QApplication::setStyle(guiStyle);
@@ -92,6 +96,30 @@ void Preferences::load()
     askOnExit = m_settings->value(QStringLiteral("AskOnExit"), true).toBool();
     useCWD = m_settings->value(QStringLiteral("UseCWD"), false).toBool();
 
+    shellPoolSize = m_settings->value(QStringLiteral("ShellPoolSize"), 1).toInt();
+    /* KiB/s per terminal, 0 is unlimited */
+    outputRateLimit = m_settings->value(QStringLiteral("OutputRateLimit"), 0).toInt();
+
+    /* output rates are in KiB/s, a frame rate of 0 paints every update */
+    m_settings->beginGroup(QStringLiteral("Rendering"));
+    frameRate = m_settings->value(QStringLiteral("FrameRate"), 60).toInt();
+    floodFrameRate = m_settings->value(QStringLiteral("FloodFrameRate"), 15).toInt();
+    coalesceThreshold = m_settings->value(QStringLiteral("CoalesceThreshold"), 64).toInt();
+    floodThreshold = m_settings->value(QStringLiteral("FloodThreshold"), 4096).toInt();
+    m_settings->endGroup();
+
+    m_settings->beginGroup(QStringLiteral("Debug"));
+    stallDetector = m_settings->value(QStringLiteral("StallDetector"), false).toBool();
+    stallThreshold = m_settings->value(QStringLiteral("StallThreshold"), 50).toInt();
+    inputLatencyProbe = m_settings->value(QStringLiteral("InputLatencyProbe"), false).toBool();
+    m_settings->endGroup();
+
+    m_settings->beginGroup(QStringLiteral("Metrics"));
+    metricsExport = m_settings->value(QStringLiteral("Export"), 0).toInt();
+    metricsPath = m_settings->value(QStringLiteral("Path")).toString();
+    metricsInterval = m_settings->value(QStringLiteral("Interval"), 15).toInt();
+    m_settings->endGroup();
+
     m_settings->beginGroup(QStringLiteral("DropMode"));
     dropKeepOpen = m_settings->value(QStringLiteral("KeepOpen"), false).toBool();
     dropShowOnStart = m_settings->value(QStringLiteral("ShowOnStart"), true).toBool();
@@ -132,6 +160,28 @@ void Preferences::save()
     m_settings->setValue(QStringLiteral("AskOnExit"), askOnExit);
     m_settings->setValue(QStringLiteral("UseCWD"), useCWD);
 
+    m_settings->setValue(QStringLiteral("ShellPoolSize"), shellPoolSize);
+    m_settings->setValue(QStringLiteral("OutputRateLimit"), outputRateLimit);
+
+    m_settings->beginGroup(QStringLiteral("Rendering"));
+    m_settings->setValue(QStringLiteral("FrameRate"), frameRate);
+    m_settings->setValue(QStringLiteral("FloodFrameRate"), floodFrameRate);
+    m_settings->setValue(QStringLiteral("CoalesceThreshold"), coalesceThreshold);
+    m_settings->setValue(QStringLiteral("FloodThreshold"), floodThreshold);
+    m_settings->endGroup();
+
+    m_settings->beginGroup(QStringLiteral("Debug"));
+    m_settings->setValue(QStringLiteral("StallDetector"), stallDetector);
+    m_settings->setValue(QStringLiteral("StallThreshold"), stallThreshold);
+    m_settings->setValue(QStringLiteral("InputLatencyProbe"), inputLatencyProbe);
+    m_settings->endGroup();
+
+    m_settings->beginGroup(QStringLiteral("Metrics"));
+    m_settings->setValue(QStringLiteral("Export"), metricsExport);
+    m_settings->setValue(QStringLiteral("Path"), metricsPath);
+    m_settings->setValue(QStringLiteral("Interval"), metricsInterval);
+    m_settings->endGroup();
+
     m_settings->beginGroup(QStringLiteral("DropMode"));
     m_settings->setValue(QStringLiteral("KeepOpen"), dropKeepOpen);
     m_settings->setValue(QStringLiteral("ShowOnStart"), dropShowOnStart);
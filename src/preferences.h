@@ -49,6 +49,8 @@ public:
     QByteArray mainWindowState;
 
     QString shellCommand;
+    int shellPoolSize;
+    int outputRateLimit;
 
     bool useSystemFont;
     QFont font;
@@ -76,8 +78,21 @@ public:
 
     bool askOnExit;
 
+    int frameRate;
+    int floodFrameRate;
+    int coalesceThreshold;
+    int floodThreshold;
+
     bool useCWD;
 
+    bool stallDetector;
+    int stallThreshold;
+    bool inputLatencyProbe;
+
+    int metricsExport;
+    QString metricsPath;
+    int metricsInterval;
+
     bool dropKeepOpen;
     bool dropShowOnStart;
     int dropWidht;
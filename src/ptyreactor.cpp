@@ -0,0 +1,144 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#include "ptyreactor.h"
+
+#include "metrics.h"
+#include "ptyreader.h"
+
+#include <QCoreApplication>
+
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace {
+const int MaxEvents = 64;
+}
+
+PtyReactor *PtyReactor::m_instance = nullptr;
+
+PtyReactor *PtyReactor::instance()
+{
+    if (!m_instance) {
+        m_instance = new PtyReactor(qApp);
+        connect(qApp, &QCoreApplication::aboutToQuit, m_instance, &PtyReactor::stop);
+        m_instance->start();
+    }
+    return m_instance;
+}
+
+PtyReactor::PtyReactor(QObject *parent) :
+    QThread(parent),
+    m_epollFd(epoll_create1(EPOLL_CLOEXEC)),
+    m_stopFd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+{
+    setObjectName(QStringLiteral("PtyReactor"));
+
+    // The stop descriptor is the only one registered without a reader
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_stopFd, &event);
+}
+
+PtyReactor::~PtyReactor()
+{
+    stop();
+    ::close(m_stopFd);
+    ::close(m_epollFd);
+    m_instance = nullptr;
+}
+
+void PtyReactor::add(PtyReader *reader)
+{
+    QMutexLocker locker(&m_mutex);
+    m_readers.insert(reader);
+
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = reader;
+    epoll_ctl(m_epollFd, EPOLL_CTL_ADD, reader->fd(), &event);
+}
+
+void PtyReactor::remove(PtyReader *reader)
+{
+    // Waits for the events being handled, which may include this reader
+    QMutexLocker locker(&m_mutex);
+    m_readers.remove(reader);
+    // Fails harmlessly for a reader that is paused or finished
+    epoll_ctl(m_epollFd, EPOLL_CTL_DEL, reader->fd(), nullptr);
+}
+
+/// Stops or resumes watching the reader, may be called from any thread
+void PtyReactor::setReading(PtyReader *reader, bool reading)
+{
+    // Hang-ups are reported even without requested events, so a paused or
+    // finished reader is taken out of the epoll set instead of modified
+    if (!reading) {
+        epoll_ctl(m_epollFd, EPOLL_CTL_DEL, reader->fd(), nullptr);
+        return;
+    }
+
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = reader;
+    epoll_ctl(m_epollFd, EPOLL_CTL_ADD, reader->fd(), &event);
+}
+
+void PtyReactor::run()
+{
+    struct epoll_event events[MaxEvents];
+
+    forever {
+        const int count = epoll_wait(m_epollFd, events, MaxEvents, -1);
+        if (count < 0) {
+            if (errno == EINTR)
+                continue;
+            qWarning("PTY reactor stopped: %s", strerror(errno));
+            return;
+        }
+
+        Metrics::add(Metrics::ReactorWakeups);
+
+        QMutexLocker locker(&m_mutex);
+        for (int i = 0; i < count; ++i) {
+            PtyReader *reader = static_cast<PtyReader *>(events[i].data.ptr);
+            if (!reader)
+                return;
+
+            // Events may still be reported for a reader removed after epoll_wait() returned
+            if (m_readers.contains(reader))
+                reader->read();
+        }
+    }
+}
+
+void PtyReactor::stop()
+{
+    if (!isRunning())
+        return;
+
+    const quint64 value = 1;
+    if (::write(m_stopFd, &value, sizeof(value)) == sizeof(value))
+        wait();
+}
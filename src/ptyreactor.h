@@ -0,0 +1,66 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#ifndef PTYREACTOR_H
+#define PTYREACTOR_H
+
+#include <QMutex>
+#include <QSet>
+#include <QThread>
+
+class PtyReader;
+
+/*! \brief Single thread reading the output of all terminal processes.
+
+The PTY masters of all readers are watched by one epoll instance. The thread
+sleeps in epoll_wait() until a process writes output, so idle shells cost no
+wakeups and no system calls, and each wakeup handles every descriptor that
+became ready. Readers are added and removed from the GUI thread; once
+remove() returns, the reader is no longer used by the reactor.
+*/
+class PtyReactor : public QThread
+{
+public:
+    static PtyReactor *instance();
+
+    void add(PtyReader *reader);
+    void remove(PtyReader *reader);
+    void setReading(PtyReader *reader, bool reading);
+
+protected:
+    void run() override;
+
+private:
+    static PtyReactor *m_instance;
+
+    explicit PtyReactor(QObject *parent = nullptr);
+    Q_DISABLE_COPY(PtyReactor)
+    ~PtyReactor() override;
+
+    void stop();
+
+    int m_epollFd = -1;
+    int m_stopFd = -1;
+
+    QMutex m_mutex;
+    QSet<PtyReader *> m_readers;
+};
+
+#endif // PTYREACTOR_H
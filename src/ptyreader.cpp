@@ -0,0 +1,129 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#include "ptyreader.h"
+
+#include "metrics.h"
+#include "outputscanner.h"
+#include "ptyreactor.h"
+#include "ringbuffer.h"
+#include "tracer.h"
+
+#include <errno.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace {
+const int BufferSize = 256 * 1024;
+const int LowWaterMark = 64 * 1024;
+}
+
+PtyReader::PtyReader(int fd, QObject *parent) :
+    QObject(parent),
+    m_fd(fd),
+    m_buffer(new RingBuffer(BufferSize)),
+    m_signalPending(0),
+    m_paused(0),
+    m_finished(0)
+{
+    PtyReactor::instance()->add(this);
+}
+
+PtyReader::~PtyReader()
+{
+    PtyReactor::instance()->remove(this);
+    ::close(m_fd);
+    delete m_buffer;
+}
+
+int PtyReader::fd() const
+{
+    return m_fd;
+}
+
+RingBuffer *PtyReader::buffer() const
+{
+    return m_buffer;
+}
+
+/// Allows the next readyRead() signal, output committed before is handled by the caller
+void PtyReader::acknowledge()
+{
+    m_signalPending.storeRelease(0);
+}
+
+/// Resumes a paused reader once the buffer has been drained far enough
+void PtyReader::consumed()
+{
+    if (m_finished.loadAcquire())
+        return;
+    if (m_buffer->size() <= LowWaterMark && m_paused.testAndSetOrdered(1, 0))
+        PtyReactor::instance()->setReading(this, true);
+}
+
+void PtyReader::read()
+{
+    TRACE_SCOPE("PtyReader::read");
+
+    // All free space is filled with a single read, epoll reports the rest again
+    struct iovec regions[2];
+    const int count = m_buffer->writeRegions(regions);
+    if (!count) {
+        pause();
+        return;
+    }
+
+    const ssize_t size = ::readv(m_fd, regions, count);
+    if (size < 0 && (errno == EAGAIN || errno == EINTR))
+        return;
+
+    // EIO means that the last process holding the PTY slave has exited
+    if (size <= 0) {
+        PtyReactor::instance()->setReading(this, false);
+        if (m_finished.testAndSetOrdered(0, 1))
+            emit finished();
+        return;
+    }
+
+    // Lines are counted on this thread, the GUI thread only hands the output on
+    int lines = 0;
+    int remaining = size;
+    for (int i = 0; i < count && remaining > 0; ++i) {
+        const int length = qMin(int(regions[i].iov_len), remaining);
+        lines += OutputScanner::countLines(static_cast<const char *>(regions[i].iov_base), length);
+        remaining -= length;
+    }
+    Metrics::add(Metrics::PtyLines, lines);
+
+    Metrics::addReadSize(size);
+    m_buffer->commit(size);
+    if (!m_signalPending.fetchAndStoreOrdered(1))
+        emit readyRead();
+}
+
+void PtyReader::pause()
+{
+    PtyReactor::instance()->setReading(this, false);
+    m_paused.storeRelease(1);
+
+    // The buffer may have been drained before the flag was visible to the GUI thread
+    if (m_buffer->size() <= LowWaterMark && m_paused.testAndSetOrdered(1, 0))
+        PtyReactor::instance()->setReading(this, true);
+}
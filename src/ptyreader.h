@@ -0,0 +1,73 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#ifndef PTYREADER_H
+#define PTYREADER_H
+
+#include <QAtomicInt>
+#include <QObject>
+
+class RingBuffer;
+
+/*! \brief Reads the output of a process from its PTY master.
+
+Reading is done by the PtyReactor thread, straight into a ring buffer that
+the GUI thread drains. readyRead() is emitted when new output is available
+and the previous signal has been acknowledged, so at most one is queued at a
+time. Once the buffer is full the master is no longer watched until the GUI
+thread has drained the buffer to the low-water mark, and the process blocks
+on its full PTY buffer. finished() is emitted once, when the last process
+holding the PTY slave has exited, and the master is not watched after that.
+
+The reader owns the master descriptor and closes it when it is deleted.
+*/
+class PtyReader : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PtyReader(int fd, QObject *parent = nullptr);
+    ~PtyReader() override;
+
+    int fd() const;
+    RingBuffer *buffer() const;
+
+    // Called from the GUI thread
+    void acknowledge();
+    void consumed();
+
+    // Called from the reactor thread
+    void read();
+
+signals:
+    void readyRead();
+    void finished();
+
+private:
+    void pause();
+
+    const int m_fd = -1;
+    RingBuffer * const m_buffer = nullptr;
+
+    QAtomicInt m_signalPending;
+    QAtomicInt m_paused;
+    QAtomicInt m_finished;
+};
+
+#endif // PTYREADER_H
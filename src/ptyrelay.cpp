@@ -0,0 +1,354 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#include "ptyrelay.h"
+
+#include "metrics.h"
+#include "outputscanner.h"
+#include "ptyreader.h"
+#include "ringbuffer.h"
+#include "tracer.h"
+
+#include <QSocketNotifier>
+#include <QTimer>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+const int WriteChunkSize = 64 * 1024;
+const int RateLimitInterval = 10; // ms
+}
+
+PtyRelay::PtyRelay(int masterFd, int pid, int terminalFd, QObject *parent) :
+    QObject(parent),
+    m_masterFd(masterFd),
+    m_pid(pid),
+    m_terminalFd(terminalFd)
+{
+    setNonBlocking(m_masterFd);
+    setNonBlocking(m_terminalFd);
+
+    // The terminal side only passes bytes through, the process PTY does the line discipline
+    struct termios ttmode;
+    if (!tcgetattr(m_terminalFd, &ttmode)) {
+        cfmakeraw(&ttmode);
+        tcsetattr(m_terminalFd, TCSANOW, &ttmode);
+    }
+
+    m_reader = new PtyReader(m_masterFd);
+    m_output = m_reader->buffer();
+    connect(m_reader, &PtyReader::readyRead, this, &PtyRelay::outputReady);
+    connect(m_reader, &PtyReader::finished, this, &PtyRelay::readerFinished);
+
+    m_masterWriteNotifier = new QSocketNotifier(m_masterFd, QSocketNotifier::Write, this);
+    m_masterWriteNotifier->setEnabled(false);
+    connect(m_masterWriteNotifier, &QSocketNotifier::activated, this, &PtyRelay::writeMaster);
+
+    m_terminalWriteNotifier = new QSocketNotifier(m_terminalFd, QSocketNotifier::Write, this);
+    m_terminalWriteNotifier->setEnabled(false);
+    connect(m_terminalWriteNotifier, &QSocketNotifier::activated,
+            this, &PtyRelay::writeTerminal);
+
+    m_batchTimer = new QTimer(this);
+    m_batchTimer->setSingleShot(true);
+    m_batchTimer->setInterval(0);
+    connect(m_batchTimer, &QTimer::timeout, this, &PtyRelay::schedule);
+
+    m_rateTimer = new QTimer(this);
+    m_rateTimer->setSingleShot(true);
+    connect(m_rateTimer, &QTimer::timeout, this, &PtyRelay::resumeReading);
+}
+
+PtyRelay::~PtyRelay()
+{
+    if (m_scheduled)
+        OutputScheduler::instance()->cancel(this);
+    close();
+}
+
+int PtyRelay::pid() const
+{
+    return m_pid;
+}
+
+int PtyRelay::masterFd() const
+{
+    return m_masterFd;
+}
+
+quint64 PtyRelay::bytesRead() const
+{
+    return m_bytesRead;
+}
+
+/// Time spent passing output on to the terminal, in microseconds
+quint64 PtyRelay::processingTime() const
+{
+    return m_processingTime;
+}
+
+void PtyRelay::sendData(const QByteArray &data)
+{
+    if (m_masterFd < 0)
+        return;
+    m_input.append(data);
+    writeMaster();
+}
+
+void PtyRelay::syncWindowSize()
+{
+    if (m_masterFd < 0)
+        return;
+
+    // The terminal keeps the size of its own PTY up to date, pass it on to the process
+    struct winsize terminalSize;
+    struct winsize processSize;
+    if (ioctl(m_terminalFd, TIOCGWINSZ, &terminalSize) < 0
+            || ioctl(m_masterFd, TIOCGWINSZ, &processSize) < 0) {
+        return;
+    }
+
+    // The terminal has not been laid out yet
+    if (!terminalSize.ws_row || !terminalSize.ws_col)
+        return;
+    if (terminalSize.ws_row == processSize.ws_row && terminalSize.ws_col == processSize.ws_col)
+        return;
+
+    ioctl(m_masterFd, TIOCSWINSZ, &terminalSize);
+}
+
+int PtyRelay::batchInterval() const
+{
+    return m_batchTimer->interval();
+}
+
+void PtyRelay::setBatchInterval(int msec)
+{
+    if (msec == m_batchTimer->interval())
+        return;
+
+    m_batchTimer->setInterval(msec);
+
+    // Whatever was collected so far is passed on right away when batching stops
+    if (!msec && m_batchTimer->isActive()) {
+        m_batchTimer->stop();
+        schedule();
+    }
+}
+
+int PtyRelay::rateLimit() const
+{
+    return m_rateLimit;
+}
+
+void PtyRelay::setRateLimit(int bytesPerSecond)
+{
+    if (bytesPerSecond == m_rateLimit)
+        return;
+
+    m_rateLimit = qMax(bytesPerSecond, 0);
+    m_rateBudget = 0;
+    m_rateClock.start();
+    resumeReading();
+}
+
+OutputScheduler::Priority PtyRelay::priority() const
+{
+    return m_priority;
+}
+
+void PtyRelay::setPriority(OutputScheduler::Priority priority)
+{
+    m_priority = priority;
+}
+
+/// Writes output until there is none left or the deadline has passed, returns true if
+/// the relay needs to be processed again
+bool PtyRelay::processOutput(qint64 deadline)
+{
+    TRACE_SCOPE("PtyRelay::processOutput");
+
+    OutputScheduler *scheduler = OutputScheduler::instance();
+    const qint64 start = scheduler->now();
+
+    WriteResult result;
+    do {
+        result = writeChunk();
+    } while (result == ChunkWritten && scheduler->now() < deadline);
+
+    const qint64 elapsed = scheduler->now() - start;
+    m_processingTime += elapsed;
+    Metrics::add(Metrics::OutputProcessingTime, elapsed);
+
+    m_scheduled = result == ChunkWritten;
+    if (result == Closed) {
+        close();
+        emit finished();
+        return false;
+    }
+
+    return m_scheduled;
+}
+
+void PtyRelay::outputReady()
+{
+    // Signals queued by the reactor may arrive after the reader has been deleted
+    if (!m_reader)
+        return;
+    m_reader->acknowledge();
+
+    // The scheduler decides when the output is passed on
+    if (!m_batchTimer->interval())
+        schedule();
+    else if (!m_batchTimer->isActive())
+        m_batchTimer->start();
+}
+
+void PtyRelay::readerFinished()
+{
+    if (!m_reader)
+        return;
+
+    // What is left in the buffer is passed on without holding it back
+    m_readerFinished = true;
+    m_batchTimer->stop();
+    m_rateTimer->stop();
+    m_rateLimited = false;
+    schedule();
+}
+
+PtyRelay::WriteResult PtyRelay::writeChunk()
+{
+    if (!m_output)
+        return Stopped;
+    if (!m_readerFinished && (m_batchTimer->isActive() || m_rateLimited))
+        return Stopped;
+
+    int available;
+    const char *data = m_output->readRegion(&available);
+    if (!available)
+        return m_readerFinished ? Closed : Drained;
+    int length = qMin(available, WriteChunkSize);
+
+    if (m_rateLimit && !m_readerFinished) {
+        // Refill the budget for the time passed, allowing bursts of up to a tenth of a second
+        const qint64 elapsed = qMin<qint64>(m_rateClock.nsecsElapsed(), 1000000000);
+        m_rateClock.restart();
+        m_rateBudget = qMin<qint64>(m_rateBudget + elapsed * m_rateLimit / 1000000000,
+                                    qMax(m_rateLimit / 10, 1));
+        if (m_rateBudget <= 0) {
+            m_rateLimited = true;
+            m_rateTimer->start(RateLimitInterval);
+            return Stopped;
+        }
+        length = static_cast<int>(qMin<qint64>(length, m_rateBudget));
+    }
+
+    // Cut where the terminal does not have to hold back a partial sequence
+    if (length < available)
+        length = OutputScanner::chunkBoundary(data, length);
+
+    ssize_t size = ::write(m_terminalFd, data, length);
+    if (size < 0) {
+        if (errno == EINTR)
+            return ChunkWritten;
+        if (errno == EAGAIN) {
+            m_terminalWriteNotifier->setEnabled(true);
+            return Stopped;
+        }
+        // The terminal is gone, the output is dropped
+        size = length;
+    }
+
+    // The reader may reuse the space as soon as it is consumed
+    m_output->consume(size);
+    m_reader->consumed();
+
+    m_bytesRead += size;
+    Metrics::add(Metrics::PtyBytesRead, size);
+    if (m_rateLimit)
+        m_rateBudget -= size;
+
+    return ChunkWritten;
+}
+
+void PtyRelay::schedule()
+{
+    if (m_scheduled || !m_output)
+        return;
+    m_scheduled = true;
+    OutputScheduler::instance()->schedule(this);
+}
+
+void PtyRelay::writeMaster()
+{
+    while (!m_input.isEmpty()) {
+        const ssize_t size = ::write(m_masterFd, m_input.constData(), m_input.size());
+        if (size < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN)
+                m_input.clear();
+            break;
+        }
+        m_input.remove(0, size);
+    }
+
+    m_masterWriteNotifier->setEnabled(!m_input.isEmpty());
+}
+
+void PtyRelay::writeTerminal()
+{
+    // The terminal has caught up
+    m_terminalWriteNotifier->setEnabled(false);
+    schedule();
+}
+
+void PtyRelay::resumeReading()
+{
+    m_rateLimited = false;
+    schedule();
+}
+
+void PtyRelay::setNonBlocking(int fd)
+{
+    const int flags = fcntl(fd, F_GETFL);
+    if (flags >= 0)
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+void PtyRelay::close()
+{
+    if (m_masterFd < 0)
+        return;
+
+    m_masterWriteNotifier->setEnabled(false);
+    m_terminalWriteNotifier->setEnabled(false);
+    m_masterFd = -1;
+
+    // The reader closes the master once the reactor no longer uses it
+    delete m_reader;
+    m_reader = nullptr;
+    m_output = nullptr;
+}
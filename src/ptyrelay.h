@@ -0,0 +1,128 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#ifndef PTYRELAY_H
+#define PTYRELAY_H
+
+#include "outputscheduler.h"
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QObject>
+
+class QSocketNotifier;
+class QTimer;
+
+class PtyReader;
+class RingBuffer;
+
+/*! \brief Connects a process PTY to a terminal running in teletype mode.
+
+Output of the process is read from the PTY master by a PtyReader on the
+PtyReactor thread and written to the terminal's own PTY straight from the
+reader's buffer. Input typed into the terminal leaves the emulation through
+QTermWidget::sendData() and is passed back the other way with sendData().
+Both directions are non-blocking, so a process or a terminal that falls
+behind never stalls the event loop. When the terminal does not keep up, the
+reader's buffer fills and the process blocks on its full PTY buffer instead
+of the terminal queueing work for the GUI thread. An optional rate limit caps
+the output of a single process the same way.
+
+With a non-zero batch interval, output is collected and handed to the terminal
+at most once per interval, which keeps terminals that are not shown from
+parsing and updating for every small read.
+*/
+class PtyRelay : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PtyRelay(int masterFd, int pid, int terminalFd, QObject *parent = nullptr);
+    ~PtyRelay() override;
+
+    int pid() const;
+    int masterFd() const;
+    quint64 bytesRead() const;
+    quint64 processingTime() const;
+
+    void sendData(const QByteArray &data);
+    void syncWindowSize();
+
+    int batchInterval() const;
+    void setBatchInterval(int msec);
+
+    int rateLimit() const;
+    void setRateLimit(int bytesPerSecond);
+
+    OutputScheduler::Priority priority() const;
+    void setPriority(OutputScheduler::Priority priority);
+
+    bool processOutput(qint64 deadline);
+
+signals:
+    void finished();
+
+private slots:
+    void outputReady();
+    void readerFinished();
+    void writeMaster();
+    void writeTerminal();
+    void resumeReading();
+
+private:
+    enum WriteResult {
+        ChunkWritten,
+        Drained,
+        Stopped,
+        Closed
+    };
+
+    static void setNonBlocking(int fd);
+    WriteResult writeChunk();
+    void schedule();
+    void close();
+
+    int m_masterFd = -1;
+    int m_pid = -1;
+    int m_terminalFd = -1;
+
+    PtyReader *m_reader = nullptr;
+    RingBuffer *m_output = nullptr; // process -> terminal, owned by the reader
+    bool m_readerFinished = false;
+
+    QSocketNotifier *m_masterWriteNotifier = nullptr;
+    QSocketNotifier *m_terminalWriteNotifier = nullptr;
+    QTimer *m_batchTimer = nullptr;
+    QTimer *m_rateTimer = nullptr;
+
+    quint64 m_bytesRead = 0;
+    quint64 m_processingTime = 0;
+
+    OutputScheduler::Priority m_priority = OutputScheduler::Visible;
+    bool m_scheduled = false;
+    bool m_rateLimited = false;
+
+    int m_rateLimit = 0;
+    qint64 m_rateBudget = 0;
+    QElapsedTimer m_rateClock;
+
+    QByteArray m_input; // terminal -> process
+};
+
+#endif // PTYRELAY_H
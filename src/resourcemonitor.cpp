@@ -0,0 +1,238 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+#include "resourcemonitor.h"
+
+#include "tabwidget.h"
+#include "termwidgetholder.h"
+
+#include <QDir>
+#include <QFile>
+#include <QHeaderView>
+#include <QTimer>
+#include <QTreeWidget>
+
+#include <unistd.h>
+
+namespace {
+const int RefreshInterval = 1000; // ms
+
+enum Column {
+    TerminalColumn,
+    CpuColumn,
+    MemoryColumn,
+    OutputColumn,
+    ProcessingColumn,
+    ScrollbackColumn,
+    PaintColumn,
+    ColumnCount
+};
+
+struct ProcessInfo {
+    int parent = 0;
+    qint64 cpuTime = 0; // clock ticks
+    qint64 rss = 0; // bytes
+};
+
+/// A snapshot of all processes, shared by all monitors
+struct ProcessTable {
+    QElapsedTimer age;
+    QHash<int, ProcessInfo> processes;
+    QMultiHash<int, int> children;
+};
+
+ProcessTable processTable;
+
+void updateProcessTable()
+{
+    if (processTable.age.isValid() && processTable.age.elapsed() < RefreshInterval / 2)
+        return;
+
+    processTable.processes.clear();
+    processTable.children.clear();
+    processTable.age.start();
+
+    const qint64 pageSize = sysconf(_SC_PAGESIZE);
+    const QStringList entries = QDir(QStringLiteral("/proc")).entryList(QDir::Dirs);
+
+    foreach (const QString &entry, entries) {
+        bool ok;
+        const int pid = entry.toInt(&ok);
+        if (!ok)
+            continue;
+
+        QFile file(QStringLiteral("/proc/%1/stat").arg(pid));
+        if (!file.open(QIODevice::ReadOnly))
+            continue;
+
+        // The command name may contain spaces, fields are counted after its closing parenthesis
+        const QByteArray stat = file.readAll();
+        const int commandEnd = stat.lastIndexOf(')');
+        if (commandEnd < 0)
+            continue;
+        const QList<QByteArray> fields = stat.mid(commandEnd + 2).split(' ');
+        if (fields.size() < 22)
+            continue;
+
+        ProcessInfo info;
+        info.parent = fields.at(1).toInt();
+        info.cpuTime = fields.at(11).toLongLong() + fields.at(12).toLongLong();
+        info.rss = fields.at(21).toLongLong() * pageSize;
+
+        processTable.processes.insert(pid, info);
+        processTable.children.insert(info.parent, pid);
+    }
+}
+
+ProcessInfo processTreeUsage(int pid)
+{
+    ProcessInfo usage;
+    QList<int> pending;
+    pending.append(pid);
+
+    while (!pending.isEmpty()) {
+        const int current = pending.takeLast();
+        const ProcessInfo info = processTable.processes.value(current);
+        usage.cpuTime += info.cpuTime;
+        usage.rss += info.rss;
+        pending.append(processTable.children.values(current));
+    }
+
+    return usage;
+}
+
+QString formatSize(qint64 size)
+{
+    if (size < 1024)
+        return QStringLiteral("%1 B").arg(size);
+    if (size < 1024 * 1024)
+        return QStringLiteral("%1 KiB").arg(size / 1024.0, 0, 'f', 1);
+    return QStringLiteral("%1 MiB").arg(size / (1024.0 * 1024.0), 0, 'f', 1);
+}
+}
+
+ResourceMonitor::ResourceMonitor(TabWidget *tabWidget, QWidget *parent) :
+    QDockWidget(tr("Resource Monitor"), parent),
+    m_tabWidget(tabWidget),
+    m_treeWidget(new QTreeWidget(this)),
+    m_timer(new QTimer(this))
+{
+    setObjectName(QStringLiteral("ResourceMonitor"));
+
+    m_treeWidget->setColumnCount(ColumnCount);
+    m_treeWidget->setHeaderLabels({ tr("Terminal"), tr("CPU"), tr("Memory"), tr("Output"),
+                                    tr("Processing"), tr("Scrollback"), tr("Paints") });
+    m_treeWidget->headerItem()->setToolTip(ProcessingColumn,
+            tr("Time spent writing output to the terminal, parsing it is not included"));
+    m_treeWidget->setRootIsDecorated(false);
+    m_treeWidget->setUniformRowHeights(true);
+    m_treeWidget->header()->setStretchLastSection(false);
+    m_treeWidget->header()->setSectionResizeMode(TerminalColumn, QHeaderView::Stretch);
+    setWidget(m_treeWidget);
+
+    m_timer->setInterval(RefreshInterval);
+    connect(m_timer, &QTimer::timeout, this, &ResourceMonitor::refresh);
+    connect(this, &ResourceMonitor::visibilityChanged, this, &ResourceMonitor::setActive);
+}
+
+void ResourceMonitor::setActive(bool active)
+{
+    if (!active) {
+        m_timer->stop();
+        m_samples.clear();
+        return;
+    }
+
+    refresh();
+    m_timer->start();
+}
+
+void ResourceMonitor::refresh()
+{
+    updateProcessTable();
+
+    const double elapsed = m_sampleTimer.isValid() ? m_sampleTimer.restart() / 1000.0 : 0;
+    if (!m_sampleTimer.isValid())
+        m_sampleTimer.start();
+    const long ticksPerSecond = sysconf(_SC_CLK_TCK);
+
+    QHash<int, Sample> samples;
+    int row = 0;
+
+    for (int i = 0; i < m_tabWidget->count(); ++i) {
+        TermWidgetHolder *holder = m_tabWidget->terminalHolder(i);
+        if (!holder)
+            continue;
+
+        const QList<TerminalWidget *> terminals = holder->terminals();
+        for (int j = 0; j < terminals.size(); ++j) {
+            TerminalWidget *terminal = terminals.at(j);
+            const int pid = terminal->shellPid();
+
+            QTreeWidgetItem *item = m_treeWidget->topLevelItem(row);
+            if (!item)
+                item = new QTreeWidgetItem(m_treeWidget);
+            ++row;
+
+            QString name = m_tabWidget->tabText(i);
+            if (terminals.size() > 1)
+                name += QStringLiteral(" (%1)").arg(j + 1);
+            item->setText(TerminalColumn, name);
+            item->setText(ScrollbackColumn, formatSize(terminal->scrollbackSize()));
+
+            // Without a process there is no tree to sum up, pid 0 would cover the whole system
+            const ProcessInfo usage = pid > 0 ? processTreeUsage(pid) : ProcessInfo();
+            item->setText(MemoryColumn, pid > 0 ? formatSize(usage.rss) : QString());
+
+            Sample sample;
+            sample.cpuTime = usage.cpuTime;
+            sample.bytesReceived = terminal->bytesReceived();
+            sample.processingTime = terminal->processingTime();
+            sample.paintCount = terminal->paintCount();
+            if (pid > 0)
+                samples.insert(pid, sample);
+
+            // Rates need a previous sample of the same process, a restarted terminal starts over
+            if (pid <= 0 || !m_samples.contains(pid) || elapsed <= 0) {
+                item->setText(CpuColumn, QString());
+                item->setText(OutputColumn, QString());
+                item->setText(ProcessingColumn, QString());
+                item->setText(PaintColumn, QString());
+                continue;
+            }
+
+            const Sample previous = m_samples.value(pid);
+            const double cpu = 100.0 * (sample.cpuTime - previous.cpuTime)
+                    / ticksPerSecond / elapsed;
+            item->setText(CpuColumn, QStringLiteral("%1%").arg(qMax(0.0, cpu), 0, 'f', 1));
+            item->setText(OutputColumn, QStringLiteral("%1/s").arg(
+                              formatSize((sample.bytesReceived - previous.bytesReceived) / elapsed)));
+            item->setText(ProcessingColumn, QStringLiteral("%1 ms/s").arg(
+                              (sample.processingTime - previous.processingTime) / 1000.0 / elapsed,
+                              0, 'f', 1));
+            item->setText(PaintColumn, QStringLiteral("%1/s").arg(
+                              (sample.paintCount - previous.paintCount) / elapsed, 0, 'f', 1));
+        }
+    }
+
+    while (m_treeWidget->topLevelItemCount() > row)
+        delete m_treeWidget->takeTopLevelItem(row);
+
+    m_samples = samples;
+}
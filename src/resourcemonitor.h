@@ -0,0 +1,65 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+#ifndef RESOURCEMONITOR_H
+#define RESOURCEMONITOR_H
+
+#include <QDockWidget>
+#include <QElapsedTimer>
+#include <QHash>
+
+class QTimer;
+class QTreeWidget;
+
+class TabWidget;
+
+/*! \brief Dock showing the resource usage of every terminal in a window.
+
+For each terminal the CPU and memory use of its process tree, the output
+rate, the time spent processing it, the scrollback size and the paint rate
+are shown. All processes are read from /proc in one pass per interval,
+shared by all monitors, and only while the dock is visible.
+*/
+class ResourceMonitor : public QDockWidget
+{
+    Q_OBJECT
+public:
+    explicit ResourceMonitor(TabWidget *tabWidget, QWidget *parent = nullptr);
+
+private slots:
+    void setActive(bool active);
+    void refresh();
+
+private:
+    struct Sample {
+        qint64 cpuTime = 0;
+        quint64 bytesReceived = 0;
+        quint64 processingTime = 0;
+        quint64 paintCount = 0;
+    };
+
+    TabWidget * const m_tabWidget = nullptr;
+    QTreeWidget *m_treeWidget = nullptr;
+    QTimer *m_timer = nullptr;
+
+    QElapsedTimer m_sampleTimer;
+    QHash<int, Sample> m_samples; // by process ID
+};
+
+#endif // RESOURCEMONITOR_H
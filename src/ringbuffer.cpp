@@ -0,0 +1,111 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#include "ringbuffer.h"
+
+#include <QtGlobal>
+
+#include <sys/uio.h>
+
+namespace {
+quint32 roundUpToPowerOfTwo(quint32 value)
+{
+    quint32 result = 1;
+    while (result < value)
+        result <<= 1;
+    return result;
+}
+}
+
+RingBuffer::RingBuffer(int capacity) :
+    m_data(new char[roundUpToPowerOfTwo(qMax(capacity, 1))]),
+    m_capacity(roundUpToPowerOfTwo(qMax(capacity, 1))),
+    m_writePosition(0),
+    m_readPosition(0)
+{
+}
+
+RingBuffer::~RingBuffer()
+{
+    delete[] m_data;
+}
+
+int RingBuffer::capacity() const
+{
+    return m_capacity;
+}
+
+int RingBuffer::size() const
+{
+    return m_writePosition.loadAcquire() - m_readPosition.loadAcquire();
+}
+
+bool RingBuffer::isEmpty() const
+{
+    return size() == 0;
+}
+
+bool RingBuffer::isFull() const
+{
+    return size() == static_cast<int>(m_capacity);
+}
+
+/// Fills \a regions with all free space, which wraps around into at most two regions,
+/// and returns the number of regions
+int RingBuffer::writeRegions(struct iovec *regions)
+{
+    const quint32 position = m_writePosition.load();
+    const quint32 free = m_capacity - (position - m_readPosition.loadAcquire());
+    if (!free)
+        return 0;
+
+    const quint32 offset = position & (m_capacity - 1);
+    const quint32 length = qMin(free, m_capacity - offset);
+    regions[0].iov_base = m_data + offset;
+    regions[0].iov_len = length;
+    if (length == free)
+        return 1;
+
+    regions[1].iov_base = m_data;
+    regions[1].iov_len = free - length;
+    return 2;
+}
+
+/// Publishes \a length bytes written into the region returned by writeRegion()
+void RingBuffer::commit(int length)
+{
+    m_writePosition.storeRelease(m_writePosition.load() + length);
+}
+
+/// Returns the contiguous data, which may be less than all data
+const char *RingBuffer::readRegion(int *length) const
+{
+    const quint32 position = m_readPosition.load();
+    const quint32 available = m_writePosition.loadAcquire() - position;
+    const quint32 offset = position & (m_capacity - 1);
+    *length = qMin(available, m_capacity - offset);
+    return m_data + offset;
+}
+
+/// Releases \a length bytes of the region returned by readRegion() to the producer
+void RingBuffer::consume(int length)
+{
+    m_readPosition.storeRelease(m_readPosition.load() + length);
+}
@@ -0,0 +1,64 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <QAtomicInteger>
+
+struct iovec;
+
+/*! \brief Lock-free byte ring buffer for a single producer and a single consumer.
+
+The producer and the consumer may run on different threads. Both sides work
+on regions inside the buffer, so data is read into and written out of it
+without intermediate copies.
+*/
+class RingBuffer
+{
+public:
+    explicit RingBuffer(int capacity);
+    ~RingBuffer();
+
+    int capacity() const;
+    int size() const;
+    bool isEmpty() const;
+    bool isFull() const;
+
+    // Producer
+    int writeRegions(struct iovec *regions);
+    void commit(int length);
+
+    // Consumer
+    const char *readRegion(int *length) const;
+    void consume(int length);
+
+private:
+    Q_DISABLE_COPY(RingBuffer)
+
+    char * const m_data = nullptr;
+    const quint32 m_capacity = 0;
+
+    // Positions only ever grow and wrap around at 2^32, the capacity is a power of two
+    QAtomicInteger<quint32> m_writePosition;
+    QAtomicInteger<quint32> m_readPosition;
+};
+
+#endif // RINGBUFFER_H
@@ -0,0 +1,165 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+#include "shellpool.h"
+
+#include "preferences.h"
+#include "terminalwidget.h"
+
+#include <QApplication>
+#include <QDir>
+#include <QTimer>
+
+namespace {
+const int RefillDelay = 250; // ms
+}
+
+ShellPool *ShellPool::m_instance = nullptr;
+
+ShellPool *ShellPool::instance()
+{
+    if (!m_instance)
+        m_instance = new ShellPool(qApp);
+    return m_instance;
+}
+
+ShellPool::ShellPool(QObject *parent) :
+    QObject(parent),
+    m_preferences(Preferences::instance()),
+    m_refillTimer(new QTimer(this)),
+    m_workingDir(QDir::currentPath()),
+    m_shellCommand(m_preferences->shellCommand)
+{
+    m_refillTimer->setSingleShot(true);
+    m_refillTimer->setInterval(RefillDelay);
+    connect(m_refillTimer, &QTimer::timeout, this, &ShellPool::refill);
+
+    connect(m_preferences, &Preferences::changed, this, &ShellPool::preferencesChanged);
+
+    // Idle shells must not outlive the event loop, nor be refilled while quitting
+    connect(qApp, &QCoreApplication::aboutToQuit, this, [this]() {
+        m_refillTimer->stop();
+        clear();
+    });
+
+    scheduleRefill();
+}
+
+ShellPool::~ShellPool()
+{
+    clear();
+    m_instance = nullptr;
+}
+
+void ShellPool::setWorkingDirectory(const QString &dir)
+{
+    if (dir == m_workingDir)
+        return;
+
+    m_workingDir = dir;
+    clear();
+    scheduleRefill();
+}
+
+TerminalWidget *ShellPool::take(const QString &workingDir, QWidget *parent)
+{
+    // Only a relayed shell can be told to change its directory
+    TerminalWidget *terminal = nullptr;
+    foreach (TerminalWidget *candidate, m_terminals) {
+        if (candidate->isRelayed()) {
+            terminal = candidate;
+            break;
+        }
+    }
+    if (!terminal)
+        return nullptr;
+
+    m_terminals.removeOne(terminal);
+    disconnect(terminal, &TerminalWidget::finished, this, &ShellPool::terminalFinished);
+    terminal->setParent(parent);
+
+    // The shell is already running, so it has to be told to change the directory
+    if (!workingDir.isEmpty() && QDir(workingDir) != QDir(m_workingDir))
+        terminal->changeDir(workingDir);
+
+    scheduleRefill();
+    return terminal;
+}
+
+void ShellPool::preferencesChanged()
+{
+    if (m_shellCommand != m_preferences->shellCommand) {
+        m_shellCommand = m_preferences->shellCommand;
+        clear();
+    } else {
+        foreach (TerminalWidget *terminal, m_terminals)
+            terminal->propertiesChanged();
+    }
+
+    while (m_terminals.size() > qMax(0, m_preferences->shellPoolSize))
+        delete m_terminals.takeLast();
+
+    scheduleRefill();
+}
+
+void ShellPool::refill()
+{
+    if (m_terminals.size() >= m_preferences->shellPoolSize)
+        return;
+
+    // A deferred terminal has no process yet, try again once startup is done
+    if (TerminalWidget::isStartDeferred()) {
+        m_refillTimer->start();
+        return;
+    }
+
+    TerminalWidget *terminal = new TerminalWidget(m_workingDir);
+
+    // Without the spawn helper no pooled shell could be used, stop trying
+    if (!terminal->isRelayed()) {
+        delete terminal;
+        return;
+    }
+
+    connect(terminal, &TerminalWidget::finished, this, &ShellPool::terminalFinished);
+    m_terminals.append(terminal);
+
+    scheduleRefill();
+}
+
+void ShellPool::terminalFinished()
+{
+    TerminalWidget *terminal = qobject_cast<TerminalWidget *>(sender());
+    Q_ASSERT(terminal);
+    m_terminals.removeAll(terminal);
+    terminal->deleteLater();
+    scheduleRefill();
+}
+
+void ShellPool::clear()
+{
+    qDeleteAll(m_terminals);
+    m_terminals.clear();
+}
+
+void ShellPool::scheduleRefill()
+{
+    if (m_terminals.size() < m_preferences->shellPoolSize && !m_refillTimer->isActive())
+        m_refillTimer->start();
+}
@@ -0,0 +1,71 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+#ifndef SHELLPOOL_H
+#define SHELLPOOL_H
+
+#include <QObject>
+
+class QTimer;
+class QWidget;
+
+class Preferences;
+class TerminalWidget;
+
+/*! \brief Pool of pre-spawned default shells.
+
+Keeps Preferences::shellPoolSize terminals with an already started shell in
+the default working directory, so new tabs and splits do not have to wait
+for the shell to start. The pool is refilled from the event loop, one shell
+at a time.
+*/
+class ShellPool : public QObject
+{
+    Q_OBJECT
+public:
+    static ShellPool *instance();
+
+    void setWorkingDirectory(const QString &dir);
+
+    TerminalWidget *take(const QString &workingDir, QWidget *parent);
+
+private slots:
+    void preferencesChanged();
+    void refill();
+    void terminalFinished();
+
+private:
+    static ShellPool *m_instance;
+
+    explicit ShellPool(QObject *parent = nullptr);
+    Q_DISABLE_COPY(ShellPool)
+    ~ShellPool() override;
+
+    void clear();
+    void scheduleRefill();
+
+    Preferences * const m_preferences = nullptr;
+    QTimer *m_refillTimer = nullptr;
+
+    QString m_workingDir;
+    QString m_shellCommand;
+    QList<TerminalWidget *> m_terminals;
+};
+
+#endif // SHELLPOOL_H
@@ -0,0 +1,382 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+#include "spawnhelper.h"
+
+#include <QByteArray>
+#include <QVector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+
+#ifdef Q_OS_LINUX
+#include <sys/prctl.h>
+#endif
+
+extern char **environ;
+
+namespace {
+const int MaxRequestSize = 256 * 1024;
+
+struct RequestHeader {
+    quint16 lines;
+    quint16 columns;
+    quint32 argumentCount;
+    quint32 environmentCount;
+};
+
+struct Response {
+    qint32 pid;
+    qint32 error;
+};
+
+void appendString(QByteArray *buffer, const QString &str)
+{
+    buffer->append(str.toLocal8Bit());
+    buffer->append('\0');
+}
+
+/// Returns the next string of a request, or nullptr if the request is truncated
+const char *takeString(const char **cursor, const char *end)
+{
+    const char *str = *cursor;
+    const char *nul = static_cast<const char *>(memchr(str, '\0', end - str));
+    if (!nul)
+        return nullptr;
+    *cursor = nul + 1;
+    return str;
+}
+
+void sendResponse(int socket, const Response &response, int fd)
+{
+    struct iovec iov;
+    iov.iov_base = const_cast<Response *>(&response);
+    iov.iov_len = sizeof(response);
+
+    char control[CMSG_SPACE(sizeof(int))];
+    memset(control, 0, sizeof(control));
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    if (fd >= 0) {
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    }
+
+    while (sendmsg(socket, &msg, MSG_NOSIGNAL) < 0 && errno == EINTR) {}
+}
+
+/// Runs in the forked child, never returns
+void execProcess(const char *slaveName, const char *workingDir, char **argv, char **envp)
+{
+    setsid();
+
+    int slaveFd = open(slaveName, O_RDWR);
+    if (slaveFd < 0)
+        _exit(127);
+
+    ioctl(slaveFd, TIOCSCTTY, 0);
+
+    struct termios ttmode;
+    if (!tcgetattr(slaveFd, &ttmode)) {
+#ifdef IUTF8
+        ttmode.c_iflag |= IUTF8;
+#endif
+        ttmode.c_cc[VERASE] = 0177;
+        tcsetattr(slaveFd, TCSANOW, &ttmode);
+    }
+
+    dup2(slaveFd, STDIN_FILENO);
+    dup2(slaveFd, STDOUT_FILENO);
+    dup2(slaveFd, STDERR_FILENO);
+    if (slaveFd > STDERR_FILENO)
+        close(slaveFd);
+
+    if (*workingDir && chdir(workingDir) < 0) {
+        const char *home = getenv("HOME");
+        if (!home || chdir(home) < 0)
+            chdir("/");
+    }
+
+    // The helper ignores SIGCHLD, the program must not inherit that
+    for (int sig = 1; sig < NSIG; ++sig)
+        signal(sig, SIG_DFL);
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigprocmask(SIG_SETMASK, &mask, nullptr);
+
+    environ = envp;
+    execvp(argv[0], argv);
+    _exit(127);
+}
+
+Response spawnProcess(const char *request, int size, int *masterFd)
+{
+    Response response = {-1, 0};
+    *masterFd = -1;
+
+    const char *end = request + size;
+    if (size < static_cast<int>(sizeof(RequestHeader))) {
+        response.error = EINVAL;
+        return response;
+    }
+
+    RequestHeader header;
+    memcpy(&header, request, sizeof(header));
+    const char *cursor = request + sizeof(header);
+
+    const char *program = takeString(&cursor, end);
+    const char *workingDir = takeString(&cursor, end);
+    if (!program || !workingDir) {
+        response.error = EINVAL;
+        return response;
+    }
+
+    QVector<char *> argv;
+    argv.append(const_cast<char *>(program));
+    for (quint32 i = 0; i < header.argumentCount; ++i) {
+        const char *arg = takeString(&cursor, end);
+        if (!arg) {
+            response.error = EINVAL;
+            return response;
+        }
+        argv.append(const_cast<char *>(arg));
+    }
+    argv.append(nullptr);
+
+    QVector<char *> envp;
+    for (quint32 i = 0; i < header.environmentCount; ++i) {
+        const char *var = takeString(&cursor, end);
+        if (!var) {
+            response.error = EINVAL;
+            return response;
+        }
+        envp.append(const_cast<char *>(var));
+    }
+    envp.append(nullptr);
+
+    int fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (fd < 0 || grantpt(fd) < 0 || unlockpt(fd) < 0) {
+        response.error = errno;
+        if (fd >= 0)
+            close(fd);
+        return response;
+    }
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    // The helper is single-threaded, ptsname() is fine here
+    const char *slaveName = ptsname(fd);
+    if (!slaveName) {
+        response.error = errno;
+        close(fd);
+        return response;
+    }
+
+    struct winsize ws;
+    memset(&ws, 0, sizeof(ws));
+    ws.ws_row = header.lines;
+    ws.ws_col = header.columns;
+    ioctl(fd, TIOCSWINSZ, &ws);
+
+    const pid_t pid = fork();
+    if (pid < 0) {
+        response.error = errno;
+        close(fd);
+        return response;
+    }
+
+    if (pid == 0)
+        execProcess(slaveName, workingDir, argv.data(), envp.data());
+
+    response.pid = pid;
+    *masterFd = fd;
+    return response;
+}
+
+void serve(int socket)
+{
+    // Let the kernel reap the spawned processes, their exit is noticed through the PTY
+    signal(SIGCHLD, SIG_IGN);
+    signal(SIGINT, SIG_IGN);
+    signal(SIGHUP, SIG_IGN);
+#ifdef Q_OS_LINUX
+    prctl(PR_SET_PDEATHSIG, SIGTERM);
+#endif
+
+    QByteArray buffer(MaxRequestSize, Qt::Uninitialized);
+
+    for (;;) {
+        const ssize_t size = recv(socket, buffer.data(), buffer.size(), MSG_TRUNC);
+        if (size < 0 && errno == EINTR)
+            continue;
+        if (size <= 0)
+            break;
+
+        int masterFd = -1;
+        Response response;
+        if (size > buffer.size()) {
+            response.pid = -1;
+            response.error = EMSGSIZE;
+        } else {
+            response = spawnProcess(buffer.constData(), size, &masterFd);
+        }
+
+        sendResponse(socket, response, masterFd);
+        if (masterFd >= 0)
+            close(masterFd);
+    }
+}
+}
+
+int SpawnHelper::m_socket = -1;
+
+bool SpawnHelper::start()
+{
+    if (m_socket >= 0)
+        return true;
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds) < 0) {
+        qWarning("Cannot create spawn helper socket: %s", strerror(errno));
+        return false;
+    }
+
+    const pid_t pid = fork();
+    if (pid < 0) {
+        qWarning("Cannot fork spawn helper: %s", strerror(errno));
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+
+    if (pid == 0) {
+        close(fds[0]);
+        serve(fds[1]);
+        _exit(0);
+    }
+
+    close(fds[1]);
+    m_socket = fds[0];
+    return true;
+}
+
+void SpawnHelper::stop()
+{
+    if (m_socket < 0)
+        return;
+    close(m_socket);
+    m_socket = -1;
+}
+
+bool SpawnHelper::isRunning()
+{
+    return m_socket >= 0;
+}
+
+SpawnHelper::Process SpawnHelper::spawn(const QString &program, const QStringList &arguments,
+                                        const QString &workingDir,
+                                        const QStringList &environment, int lines, int columns)
+{
+    Process process;
+    if (m_socket < 0)
+        return process;
+
+    RequestHeader header;
+    header.lines = lines;
+    header.columns = columns;
+    header.argumentCount = arguments.size();
+    header.environmentCount = environment.size();
+
+    QByteArray request(reinterpret_cast<const char *>(&header), sizeof(header));
+    appendString(&request, program);
+    appendString(&request, workingDir);
+    foreach (const QString &arg, arguments)
+        appendString(&request, arg);
+    foreach (const QString &var, environment)
+        appendString(&request, var);
+
+    if (request.size() > MaxRequestSize) {
+        qWarning("Spawn request for '%s' is too large.", qPrintable(program));
+        return process;
+    }
+
+    ssize_t sent;
+    do {
+        sent = send(m_socket, request.constData(), request.size(), MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+
+    if (sent < 0) {
+        qWarning("Spawn helper is gone: %s", strerror(errno));
+        stop();
+        return process;
+    }
+
+    Response response;
+    struct iovec iov;
+    iov.iov_base = &response;
+    iov.iov_len = sizeof(response);
+
+    char control[CMSG_SPACE(sizeof(int))];
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t received;
+    do {
+        received = recvmsg(m_socket, &msg, MSG_CMSG_CLOEXEC);
+    } while (received < 0 && errno == EINTR);
+
+    if (received != sizeof(response)) {
+        qWarning("Spawn helper is gone.");
+        stop();
+        return process;
+    }
+
+    if (response.pid < 0) {
+        qWarning("Cannot start '%s': %s", qPrintable(program), strerror(response.error));
+        return process;
+    }
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if (!cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+        return process;
+
+    memcpy(&process.masterFd, CMSG_DATA(cmsg), sizeof(int));
+    process.pid = response.pid;
+    return process;
+}
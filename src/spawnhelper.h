@@ -0,0 +1,55 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+#ifndef SPAWNHELPER_H
+#define SPAWNHELPER_H
+
+#include <QStringList>
+
+/*! \brief Fork server for terminal processes.
+
+The helper is forked from main() before QApplication is created, while the
+process is still small. Shells are forked from the helper instead of from the
+GUI process, so the cost of a spawn does not grow with the amount of memory
+(scrollback, fonts, pixmaps) the GUI process holds.
+
+The helper opens the PTY, starts the program on its slave side and passes the
+master file descriptor back over a Unix socket.
+*/
+class SpawnHelper
+{
+public:
+    struct Process {
+        int masterFd = -1;
+        int pid = -1;
+    };
+
+    static bool start();
+    static void stop();
+    static bool isRunning();
+
+    static Process spawn(const QString &program, const QStringList &arguments,
+                         const QString &workingDir, const QStringList &environment,
+                         int lines = 24, int columns = 80);
+
+private:
+    static int m_socket;
+};
+
+#endif // SPAWNHELPER_H
@@ -0,0 +1,278 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+#include "stalldetector.h"
+
+#include "tabwidget.h"
+#include "terminalwidget.h"
+
+#include <QApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QStandardPaths>
+#include <QThread>
+
+#include <execinfo.h>
+#include <signal.h>
+#include <stdlib.h>
+
+namespace {
+const int PingInterval = 20; // ms
+const int BucketCount = 12; // up to 1 ms, 2 ms, ..., 1024 ms and above
+const int MaxFrames = 64;
+const int CaptureTimeout = 100; // ms
+const int CaptureSignal = SIGUSR2;
+
+// Filled in by the signal handler on the GUI thread
+void *stackFrames[MaxFrames];
+QAtomicInt stackFrameCount(-1);
+
+void captureSignalHandler(int)
+{
+    stackFrameCount.storeRelease(backtrace(stackFrames, MaxFrames));
+}
+}
+
+class StallDetector::Watchdog : public QThread
+{
+public:
+    explicit Watchdog(StallDetector *detector) :
+        m_detector(detector)
+    {
+    }
+
+protected:
+    void run() override
+    {
+        m_detector->watch();
+    }
+
+private:
+    StallDetector * const m_detector;
+};
+
+StallDetector *StallDetector::m_instance = nullptr;
+
+StallDetector *StallDetector::instance()
+{
+    if (!m_instance)
+        m_instance = new StallDetector(qApp);
+    return m_instance;
+}
+
+StallDetector::StallDetector(QObject *parent) :
+    QObject(parent),
+    m_guiThread(pthread_self()),
+    m_histogram(BucketCount, 0)
+{
+    m_clock.start();
+}
+
+StallDetector::~StallDetector()
+{
+    stop();
+    m_instance = nullptr;
+}
+
+bool StallDetector::isRunning() const
+{
+    return m_watchdog != nullptr;
+}
+
+void StallDetector::start(int threshold)
+{
+    m_threshold = threshold;
+    if (m_watchdog)
+        return;
+
+    // backtrace() allocates on its first call, which must not happen in a signal handler
+    void *frame;
+    backtrace(&frame, 1);
+
+    struct sigaction action;
+    action.sa_handler = captureSignalHandler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(CaptureSignal, &action, nullptr);
+
+    m_stopping.store(0);
+    m_pingPending.store(0);
+    m_watchdog = new Watchdog(this);
+    m_watchdog->start(QThread::HighPriority);
+}
+
+void StallDetector::stop()
+{
+    if (!m_watchdog)
+        return;
+
+    m_stopping.store(1);
+    m_watchdog->wait();
+    delete m_watchdog;
+    m_watchdog = nullptr;
+
+    signal(CaptureSignal, SIG_DFL);
+}
+
+int StallDetector::threshold() const
+{
+    return m_threshold;
+}
+
+QString StallDetector::logFileName() const
+{
+    const QDir dir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+    return dir.absoluteFilePath(QStringLiteral("stalls.log"));
+}
+
+int StallDetector::stallCount() const
+{
+    return m_stallCount;
+}
+
+QVector<int> StallDetector::histogram() const
+{
+    return m_histogram;
+}
+
+int StallDetector::bucketLimit(int bucket)
+{
+    return bucket < BucketCount - 1 ? 1 << bucket : -1;
+}
+
+void StallDetector::pong(qint64 sent)
+{
+    const qint64 latency = (m_clock.nsecsElapsed() - sent) / 1000000;
+
+    int bucket = 0;
+    while (bucket < BucketCount - 1 && latency >= bucketLimit(bucket))
+        ++bucket;
+    ++m_histogram[bucket];
+
+    if (latency >= m_threshold) {
+        ++m_stallCount;
+
+        QMutexLocker locker(&m_mutex);
+        QString entry = QStringLiteral("%1 GUI thread blocked for %2 ms, active terminal: %3\n")
+                .arg(QDateTime::currentDateTime().toString(Qt::ISODate))
+                .arg(latency)
+                .arg(activeTerminalDescription());
+        foreach (const QString &frame, m_stack)
+            entry += QStringLiteral("    %1\n").arg(frame);
+        m_stack.clear();
+        m_pendingLog.append(entry);
+    }
+
+    m_pingPending.storeRelease(0);
+}
+
+void StallDetector::watch()
+{
+    const int pollInterval = qBound(1, qMin(PingInterval, m_threshold / 2), PingInterval);
+
+    while (!m_stopping.load()) {
+        const qint64 now = m_clock.nsecsElapsed();
+
+        if (!m_pingPending.loadAcquire()) {
+            m_pingSent = now;
+            m_stackCaptured = false;
+            m_pingPending.storeRelease(1);
+            QMetaObject::invokeMethod(this, "pong", Qt::QueuedConnection, Q_ARG(qint64, now));
+        } else if (!m_stackCaptured && now - m_pingSent >= m_threshold * 1000000LL) {
+            m_stackCaptured = true;
+            captureBacktrace();
+        }
+
+        writeLog();
+        QThread::msleep(m_pingPending.loadAcquire() ? pollInterval : PingInterval);
+    }
+
+    writeLog();
+}
+
+void StallDetector::captureBacktrace()
+{
+    stackFrameCount.storeRelease(-1);
+    if (pthread_kill(m_guiThread, CaptureSignal))
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+    while (stackFrameCount.loadAcquire() < 0) {
+        if (timer.elapsed() > CaptureTimeout)
+            return;
+        QThread::usleep(100);
+    }
+
+    const int count = stackFrameCount.loadAcquire();
+    char **symbols = backtrace_symbols(stackFrames, count);
+    if (!symbols)
+        return;
+
+    QStringList stack;
+    // Skip the signal handler and the signal trampoline
+    for (int i = 2; i < count; ++i)
+        stack.append(QString::fromLocal8Bit(symbols[i]));
+    free(symbols);
+
+    QMutexLocker locker(&m_mutex);
+    m_stack = stack;
+}
+
+QString StallDetector::activeTerminalDescription() const
+{
+    TerminalWidget *terminal = nullptr;
+    TabWidget *tabWidget = nullptr;
+    for (QWidget *widget = QApplication::focusWidget(); widget; widget = widget->parentWidget()) {
+        if (!terminal)
+            terminal = qobject_cast<TerminalWidget *>(widget);
+        if (!tabWidget)
+            tabWidget = qobject_cast<TabWidget *>(widget);
+    }
+
+    if (!terminal || !tabWidget)
+        return QStringLiteral("none");
+
+    return QStringLiteral("'%1' in %2").arg(tabWidget->tabText(tabWidget->currentIndex()),
+                                           terminal->workingDirectory());
+}
+
+void StallDetector::writeLog()
+{
+    QStringList entries;
+    {
+        QMutexLocker locker(&m_mutex);
+        entries.swap(m_pendingLog);
+    }
+
+    if (entries.isEmpty())
+        return;
+
+    const QString fileName = logFileName();
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append))
+        return;
+    foreach (const QString &entry, entries)
+        file.write(entry.toLocal8Bit());
+}
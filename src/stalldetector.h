@@ -0,0 +1,92 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+#ifndef STALLDETECTOR_H
+#define STALLDETECTOR_H
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+
+#include <pthread.h>
+
+/*! \brief GUI thread watchdog.
+
+A watchdog thread keeps one ping queued on the GUI event loop and measures
+how long it takes to be delivered. Latencies go to a histogram. When a ping
+waits longer than the threshold, the watchdog captures a backtrace of the GUI
+thread, and the stall is logged with its duration and the active terminal
+once the event loop is back.
+*/
+class StallDetector : public QObject
+{
+    Q_OBJECT
+public:
+    static StallDetector *instance();
+
+    bool isRunning() const;
+    void start(int threshold);
+    void stop();
+
+    int threshold() const;
+    QString logFileName() const;
+
+    int stallCount() const;
+    QVector<int> histogram() const;
+    static int bucketLimit(int bucket);
+
+private slots:
+    void pong(qint64 sent);
+
+private:
+    class Watchdog;
+
+    static StallDetector *m_instance;
+
+    explicit StallDetector(QObject *parent = nullptr);
+    Q_DISABLE_COPY(StallDetector)
+    ~StallDetector() override;
+
+    void watch();
+    void captureBacktrace();
+    QString activeTerminalDescription() const;
+    void writeLog();
+
+    Watchdog *m_watchdog = nullptr;
+    pthread_t m_guiThread;
+
+    QElapsedTimer m_clock;
+    QAtomicInt m_stopping;
+    QAtomicInt m_pingPending;
+    qint64 m_pingSent = 0; // only touched by the watchdog
+    bool m_stackCaptured = false; // only touched by the watchdog
+
+    int m_threshold = 0;
+    int m_stallCount = 0;
+    QVector<int> m_histogram;
+
+    mutable QMutex m_mutex;
+    QStringList m_stack;
+    QStringList m_pendingLog;
+};
+
+#endif // STALLDETECTOR_H
@@ -0,0 +1,48 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+#include "startuptimer.h"
+
+#include <stdio.h>
+
+QElapsedTimer StartupTimer::m_timer;
+QList<QPair<QString, qint64>> StartupTimer::m_phases;
+
+void StartupTimer::start()
+{
+    m_phases.clear();
+    m_timer.start();
+}
+
+void StartupTimer::mark(const QString &phase)
+{
+    if (!m_timer.isValid())
+        return;
+    m_phases.append(qMakePair(phase, m_timer.nsecsElapsed()));
+}
+
+void StartupTimer::report()
+{
+    qint64 previous = 0;
+    for (auto it = m_phases.cbegin(); it != m_phases.cend(); ++it) {
+        fprintf(stderr, "%8.2f ms %+8.2f ms  %s\n", it->second / 1e6,
+                (it->second - previous) / 1e6, qPrintable(it->first));
+        previous = it->second;
+    }
+}
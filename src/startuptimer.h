@@ -0,0 +1,45 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+#ifndef STARTUPTIMER_H
+#define STARTUPTIMER_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QPair>
+#include <QString>
+
+/*! \brief Records how long the startup phases take.
+
+The timer is started at the top of main(), each phase is marked when it is
+done. The report is printed with --startup-report.
+*/
+class StartupTimer
+{
+public:
+    static void start();
+    static void mark(const QString &phase);
+    static void report();
+
+private:
+    static QElapsedTimer m_timer;
+    static QList<QPair<QString, qint64>> m_phases;
+};
+
+#endif // STARTUPTIMER_H
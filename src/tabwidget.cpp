@@ -23,6 +23,7 @@
 
 #include "preferences.h"
 #include "termwidgetholder.h"
+#include "tracer.h"
 
 #include <QActionGroup>
 #include <QEvent>
@@ -67,18 +68,27 @@ TermWidgetHolder *TabWidget::terminalHolder() const
     return reinterpret_cast<TermWidgetHolder *>(widget(currentIndex()));
 }
 
+TermWidgetHolder *TabWidget::terminalHolder(int index) const
+{
+    return qobject_cast<TermWidgetHolder *>(widget(index));
+}
+
 void TabWidget::setWorkDirectory(const QString &dir)
 {
     m_workingDir = dir;
 }
 
-void TabWidget::addNewTab(const QString &command)
+void TabWidget::addNewTab(const QString &command, const QString &workingDir)
 {
+    TRACE_SCOPE("TabWidget::addNewTab");
+
     const QString label = QString(tr("Shell No. %1")).arg(++m_tabNumerator);
 
     TermWidgetHolder *ch = terminalHolder();
     QString cwd(m_workingDir);
-    if (Preferences::instance()->useCWD && ch) {
+    if (!workingDir.isEmpty()) {
+        cwd = workingDir;
+    } else if (Preferences::instance()->useCWD && ch) {
         cwd = ch->currentTerminal()->workingDirectory();
         if (cwd.isEmpty())
             cwd = m_workingDir;
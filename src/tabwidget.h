@@ -39,9 +39,10 @@ public:
     void setContextMenu(QMenu *menu);
 
     TermWidgetHolder *terminalHolder() const;
+    TermWidgetHolder *terminalHolder(int index) const;
 
 public slots:
-    void addNewTab(const QString &command = QString());
+    void addNewTab(const QString &command = QString(), const QString &workingDir = QString());
     void removeTab(int);
     void removeCurrentTab();
     void switchToRight();
@@ -20,40 +20,76 @@
 
 #include "terminalwidget.h"
 
+#include "inputlatency.h"
+#include "metrics.h"
 #include "preferences.h"
+#include "ptyrelay.h"
+#include "spawnhelper.h"
+#include "tracer.h"
 
 #include <QDesktopServices>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
 #include <QPainter>
+#include <QProcessEnvironment>
+#include <QTimer>
 #include <QVBoxLayout>
 
+#include <sys/ioctl.h>
+#include <unistd.h>
+
 namespace {
 const bool FlowControlEnabled = false;
 const bool FlowControlWarningEnabled = false;
+
+// Approximate size of a Konsole::Character kept in the history
+const int CharacterSize = 12;
+
+const qint64 EchoTimeout = 1000000; // us
+
+const int WindowSizeDelay = 100; // ms
+const int SuspendedBatchInterval = 250; // ms
 }
 
+bool TerminalWidget::m_startDeferred = false;
+QList<QPointer<TerminalWidget>> TerminalWidget::m_pendingStarts;
+
 TerminalWidget::TerminalWidget(const QString &workingDir, const QString &command, QWidget *parent) :
     QTermWidget(0, parent),
-    m_preferences(Preferences::instance())
+    m_preferences(Preferences::instance()),
+    m_workingDir(workingDir)
 {
     setFlowControlEnabled(FlowControlEnabled);
     setFlowControlWarningEnabled(FlowControlWarningEnabled);
 
-    if (!workingDir.isNull())
-        setWorkingDirectory(workingDir);
-
     if (command.isNull()) {
         if (!m_preferences->shellCommand.isNull())
-            setShellProgram(m_preferences->shellCommand);
+            m_program = m_preferences->shellCommand;
     } else {
-        QStringList parts = command.split(QRegExp("\\s+"), QString::SkipEmptyParts);
-        setShellProgram(parts.first());
-        parts.removeFirst();
-        if (parts.count())
-            setArgs(parts);
+        m_arguments = command.split(QRegExp("\\s+"), QString::SkipEmptyParts);
+        if (!m_arguments.isEmpty())
+            m_program = m_arguments.takeFirst();
     }
 
     setMotionAfterPasting(m_preferences->motionAfterPaste);
-    startShellProgram();
+
+    foreach (QWidget *child, findChildren<QWidget *>(QString(), Qt::FindDirectChildrenOnly)) {
+        if (child->inherits("Konsole::TerminalDisplay")) {
+            m_display = child;
+            m_display->installEventFilter(this);
+            break;
+        }
+    }
+
+    // While output streams in, paints are held back to at most one per frame
+    m_frameTimer = new QTimer(this);
+    m_frameTimer->setSingleShot(true);
+    connect(m_frameTimer, &QTimer::timeout, this, [this]() {
+        m_frameDeferred = false;
+        updateDisplayEnabled();
+    });
+    m_frameClock.start();
 
     propertiesChanged();
 
@@ -64,10 +100,41 @@ TerminalWidget::TerminalWidget(const QString &workingDir, const QString &command
     connect(this, &QTermWidget::urlActivated, this, [](const QUrl &url) {
         QDesktopServices::openUrl(url);
     });
+
+    if (m_startDeferred)
+        m_pendingStarts.append(this);
+    else
+        start();
+}
+
+void TerminalWidget::start()
+{
+    if (m_started)
+        return;
+    m_started = true;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    if (startProcess(m_workingDir, m_program, m_arguments)) {
+        Metrics::addSpawnLatency(timer.nsecsElapsed() / 1000);
+        return;
+    }
+
+    if (!m_workingDir.isNull())
+        setWorkingDirectory(m_workingDir);
+    if (!m_program.isEmpty())
+        setShellProgram(m_program);
+    if (!m_arguments.isEmpty())
+        setArgs(m_arguments);
+    startShellProgram();
+    Metrics::addSpawnLatency(timer.nsecsElapsed() / 1000);
 }
 
 void TerminalWidget::propertiesChanged()
 {
+    TRACE_SCOPE("TerminalWidget::propertiesChanged");
+
     setColorScheme(m_preferences->colorScheme);
     setTerminalFont(m_preferences->terminalFont());
     setMotionAfterPasting(m_preferences->motionAfterPaste);
@@ -76,6 +143,8 @@ void TerminalWidget::propertiesChanged()
     setTerminalOpacity(m_preferences->terminalOpacity / 100.0);
     setScrollBarPosition(
                 static_cast<QTermWidget::ScrollBarPosition>(m_preferences->scrollBarPosition));
+    if (m_relay)
+        m_relay->setRateLimit(m_preferences->outputRateLimit * 1024);
     update();
 }
 
@@ -83,3 +152,262 @@ void TerminalWidget::zoomReset()
 {
     setTerminalFont(m_preferences->terminalFont());
 }
+
+QString TerminalWidget::workingDirectory()
+{
+    if (!m_relay)
+        return QTermWidget::workingDirectory();
+
+    const QFileInfo cwd(QStringLiteral("/proc/%1/cwd").arg(m_relay->pid()));
+    return cwd.exists() ? cwd.symLinkTarget() : QString();
+}
+
+void TerminalWidget::changeDir(const QString &dir)
+{
+    if (!m_relay) {
+        QTermWidget::changeDir(dir);
+        return;
+    }
+
+    // Only type the command if the shell is not running anything in the foreground
+    if (tcgetpgrp(m_relay->masterFd()) != m_relay->pid())
+        return;
+
+    QString quoted(dir);
+    quoted.replace(QLatin1Char('\''), QLatin1String("'\\''"));
+    m_relay->sendData(QStringLiteral(" cd '%1'\n").arg(quoted).toLocal8Bit());
+}
+
+int TerminalWidget::shellPid()
+{
+    return m_relay ? m_relay->pid() : getShellPID();
+}
+
+/// Whether the process was started by the spawn helper and is relayed through a PtyRelay
+bool TerminalWidget::isRelayed() const
+{
+    return m_relay;
+}
+
+quint64 TerminalWidget::bytesReceived() const
+{
+    return m_relay ? m_relay->bytesRead() : 0;
+}
+
+quint64 TerminalWidget::paintCount() const
+{
+    return m_paintCount;
+}
+
+qint64 TerminalWidget::scrollbackSize()
+{
+    return qint64(historyLinesCount()) * screenColumnsCount() * CharacterSize;
+}
+
+bool TerminalWidget::isSuspended() const
+{
+    return m_suspended;
+}
+
+void TerminalWidget::updateSuspended()
+{
+    const bool suspended = !isVisible() || window()->isMinimized();
+    if (suspended == m_suspended)
+        return;
+    m_suspended = suspended;
+
+    // A suspended terminal keeps parsing output, but in batches and without painting.
+    // Enabling updates again repaints the display once from the current screen.
+    updateDisplayEnabled();
+    if (m_relay)
+        m_relay->setBatchInterval(suspended ? SuspendedBatchInterval : 0);
+    updatePriority();
+}
+
+void TerminalWidget::setCurrent(bool current)
+{
+    m_current = current;
+    updatePriority();
+}
+
+quint64 TerminalWidget::processingTime() const
+{
+    return m_relay ? m_relay->processingTime() : 0;
+}
+
+bool TerminalWidget::isStartDeferred()
+{
+    return m_startDeferred;
+}
+
+void TerminalWidget::setStartDeferred(bool deferred)
+{
+    m_startDeferred = deferred;
+    if (deferred)
+        return;
+
+    foreach (const QPointer<TerminalWidget> &terminal, m_pendingStarts) {
+        if (terminal)
+            terminal->start();
+    }
+    m_pendingStarts.clear();
+}
+
+bool TerminalWidget::eventFilter(QObject *object, QEvent *event)
+{
+    if (object != m_display)
+        return QTermWidget::eventFilter(object, event);
+
+    // Keys without an echo must not be matched with later output
+    if (event->type() == QEvent::KeyPress && InputLatency::isEnabled() && m_relay
+            && (m_keyPressTime < 0 || InputLatency::now() - m_keyPressTime > EchoTimeout)) {
+        m_keyPressTime = InputLatency::now();
+        m_keyPressBytes = m_relay->bytesRead();
+        m_keyPressTotalBytes = Metrics::value(Metrics::PtyBytesRead);
+    }
+
+    if (event->type() != QEvent::Paint)
+        return QTermWidget::eventFilter(object, event);
+
+    ++m_paintCount;
+    Metrics::add(Metrics::Paints);
+
+    // The first paint after the echo has been read shows the typed character
+    const bool echoPending = m_keyPressTime >= 0 && m_relay->bytesRead() > m_keyPressBytes;
+
+    // Deliver the event here, so that the measurements cover the whole paint
+    {
+        TRACE_SCOPE("TerminalDisplay::paintEvent");
+        static_cast<QObject *>(m_display)->event(event);
+    }
+
+    if (echoPending) {
+        const quint64 ownBytes = m_relay->bytesRead() - m_keyPressBytes;
+        const quint64 totalBytes = Metrics::value(Metrics::PtyBytesRead) - m_keyPressTotalBytes;
+        InputLatency::addSample(InputLatency::now() - m_keyPressTime, totalBytes > ownBytes);
+        m_keyPressTime = -1;
+    }
+
+    scheduleFrame();
+    return true;
+}
+
+void TerminalWidget::scheduleFrame()
+{
+    if (!m_relay)
+        return;
+
+    // Output rate since the previous frame, in KiB/s
+    const quint64 bytes = m_relay->bytesRead() - m_frameBytes;
+    const qint64 elapsed = qMax<qint64>(m_frameClock.restart(), 1);
+    const qint64 rate = bytes * 1000 / 1024 / elapsed;
+    m_frameBytes = m_relay->bytesRead();
+
+    // Stay at the flood rate until the output has clearly subsided
+    if (rate > m_preferences->floodThreshold)
+        m_flooded = true;
+    else if (rate < m_preferences->floodThreshold / 2)
+        m_flooded = false;
+
+    if (rate < m_preferences->coalesceThreshold)
+        return;
+
+    const int frameRate = m_flooded ? m_preferences->floodFrameRate : m_preferences->frameRate;
+    if (frameRate <= 0)
+        return;
+
+    // Updates made until the next frame are dropped, enabling updates again repaints
+    // the whole display once, which skips the intermediate states
+    m_frameDeferred = true;
+    updateDisplayEnabled();
+    m_frameTimer->start(1000 / frameRate);
+}
+
+void TerminalWidget::updatePriority()
+{
+    if (!m_relay)
+        return;
+
+    if (m_suspended)
+        m_relay->setPriority(OutputScheduler::Background);
+    else if (m_current)
+        m_relay->setPriority(OutputScheduler::Focused);
+    else
+        m_relay->setPriority(OutputScheduler::Visible);
+}
+
+void TerminalWidget::updateDisplayEnabled()
+{
+    if (m_display)
+        m_display->setUpdatesEnabled(!m_suspended && !m_frameDeferred);
+}
+
+void TerminalWidget::resizeEvent(QResizeEvent *event)
+{
+    QTermWidget::resizeEvent(event);
+
+    // The display is laid out right away, the process only learns about the size once
+    // it stops changing, so that dragging a splitter does not make it redraw continuously
+    if (m_windowSizeTimer)
+        m_windowSizeTimer->start();
+}
+
+void TerminalWidget::showEvent(QShowEvent *event)
+{
+    QTermWidget::showEvent(event);
+    updateSuspended();
+}
+
+void TerminalWidget::hideEvent(QHideEvent *event)
+{
+    QTermWidget::hideEvent(event);
+    updateSuspended();
+}
+
+bool TerminalWidget::startProcess(const QString &workingDir, const QString &program,
+                                  const QStringList &arguments)
+{
+    if (!SpawnHelper::isRunning())
+        return false;
+
+    QString shell(program);
+    if (shell.isEmpty())
+        shell = QString::fromLocal8Bit(qgetenv("SHELL"));
+    if (shell.isEmpty())
+        shell = QStringLiteral("/bin/sh");
+
+    // Start the process with the size the terminal already has
+    struct winsize ws;
+    if (ioctl(getPtySlaveFd(), TIOCGWINSZ, &ws) < 0 || !ws.ws_row || !ws.ws_col) {
+        ws.ws_row = 24;
+        ws.ws_col = 80;
+    }
+
+    const SpawnHelper::Process process
+            = SpawnHelper::spawn(shell, arguments,
+                                 workingDir.isNull() ? QDir::currentPath() : workingDir,
+                                 QProcessEnvironment::systemEnvironment().toStringList(),
+                                 ws.ws_row, ws.ws_col);
+    if (process.masterFd < 0)
+        return false;
+
+    startTerminalTeletype();
+
+    m_relay = new PtyRelay(process.masterFd, process.pid, getPtySlaveFd(), this);
+    connect(m_relay, &PtyRelay::finished, this, &TerminalWidget::finished);
+    // In teletype mode keys, pastes and terminal replies only leave through sendData()
+    connect(this, &QTermWidget::sendData, m_relay, [this](const char *data, int size) {
+        m_relay->sendData(QByteArray(data, size));
+    });
+    m_relay->setRateLimit(m_preferences->outputRateLimit * 1024);
+    if (m_suspended)
+        m_relay->setBatchInterval(SuspendedBatchInterval);
+    updatePriority();
+
+    m_windowSizeTimer = new QTimer(this);
+    m_windowSizeTimer->setSingleShot(true);
+    m_windowSizeTimer->setInterval(WindowSizeDelay);
+    connect(m_windowSizeTimer, &QTimer::timeout, m_relay, &PtyRelay::syncWindowSize);
+
+    return true;
+}
@@ -23,7 +23,13 @@
 
 #include <qtermwidget.h>
 
+#include <QElapsedTimer>
+#include <QPointer>
+
+class QTimer;
+
 class Preferences;
+class PtyRelay;
 
 class TerminalWidget : public QTermWidget
 {
@@ -32,16 +38,77 @@ public:
     explicit TerminalWidget(const QString &workingDir, const QString &command = QString(),
                         QWidget *parent = nullptr);
 
+    void start();
     void propertiesChanged();
 
     void zoomReset();
 
+    static bool isStartDeferred();
+    static void setStartDeferred(bool deferred);
+
+    // Hide QTermWidget versions, they only know about the shell started by QTermWidget itself
+    QString workingDirectory();
+    void changeDir(const QString &dir);
+
+    int shellPid();
+    bool isRelayed() const;
+    quint64 bytesReceived() const;
+    quint64 paintCount() const;
+    qint64 scrollbackSize();
+
+    bool isSuspended() const;
+    void updateSuspended();
+
+    void setCurrent(bool current);
+    quint64 processingTime() const;
+
 signals:
     void finished();
     void focused(TerminalWidget *self);
 
+protected:
+    bool eventFilter(QObject *object, QEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
 private:
+    bool startProcess(const QString &workingDir, const QString &program,
+                      const QStringList &arguments);
+    void scheduleFrame();
+    void updatePriority();
+    void updateDisplayEnabled();
+
+    static bool m_startDeferred;
+    static QList<QPointer<TerminalWidget>> m_pendingStarts;
+
     Preferences * const m_preferences = nullptr;
+
+    QString m_workingDir;
+    QString m_program;
+    QStringList m_arguments;
+    bool m_started = false;
+    bool m_suspended = false;
+    bool m_current = false;
+
+    // Process started by the spawn helper
+    PtyRelay *m_relay = nullptr;
+    QTimer *m_windowSizeTimer = nullptr;
+
+    QWidget *m_display = nullptr;
+    quint64 m_paintCount = 0;
+
+    // Frame coalescing
+    QTimer *m_frameTimer = nullptr;
+    QElapsedTimer m_frameClock;
+    quint64 m_frameBytes = 0;
+    bool m_frameDeferred = false;
+    bool m_flooded = false;
+
+    // Input latency probe
+    qint64 m_keyPressTime = -1;
+    quint64 m_keyPressBytes = 0;
+    quint64 m_keyPressTotalBytes = 0;
 };
 
 #endif // TERMWIDGET_H
@@ -21,11 +21,35 @@
 #include "termwidgetholder.h"
 
 #include "preferences.h"
+#include "shellpool.h"
+#include "tracer.h"
 
 #include <QVBoxLayout>
 #include <QInputDialog>
 #include <QSplitter>
 
+#include <climits>
+
+namespace {
+const int MaxGridSize = 64;
+
+QSplitter *parentSplitter(QWidget *widget)
+{
+    return qobject_cast<QSplitter *>(widget->parentWidget());
+}
+
+/// Returns the first or the last terminal in the subtree of \a node
+TerminalWidget *edgeTerminal(QWidget *node, bool first)
+{
+    while (QSplitter *splitter = qobject_cast<QSplitter *>(node)) {
+        if (!splitter->count())
+            return nullptr;
+        node = splitter->widget(first ? 0 : splitter->count() - 1);
+    }
+    return qobject_cast<TerminalWidget *>(node);
+}
+}
+
 TermWidgetHolder::TermWidgetHolder(const QString &wdir, const QString &shell, QWidget *parent) :
     QWidget(parent),
     m_workingDir(wdir),
@@ -38,21 +62,22 @@ TermWidgetHolder::TermWidgetHolder(const QString &wdir, const QString &shell, QW
     layout->setContentsMargins(0, 0, 0, 0);
 
     TerminalWidget *terminal = newTerm();
+    m_terminals.append(terminal);
+    setCurrentTerminal(terminal);
 
-    QSplitter *splitter = new QSplitter(this);
-    splitter->setFocusPolicy(Qt::NoFocus);
-    splitter->addWidget(terminal);
+    m_rootSplitter = new QSplitter(this);
+    m_rootSplitter->setFocusPolicy(Qt::NoFocus);
+    m_rootSplitter->addWidget(terminal);
 
-    layout->addWidget(splitter);
+    layout->addWidget(m_rootSplitter);
     setLayout(layout);
 }
 
 void TermWidgetHolder::setInitialFocus()
 {
-    QList<TerminalWidget *> list = findChildren<TerminalWidget *>();
-    if (list.isEmpty())
+    if (m_terminals.isEmpty())
         return;
-    list.first()->setFocus(Qt::OtherFocusReason);
+    m_terminals.first()->setFocus(Qt::OtherFocusReason);
 }
 
 TerminalWidget *TermWidgetHolder::currentTerminal() const
@@ -60,48 +85,32 @@ TerminalWidget *TermWidgetHolder::currentTerminal() const
     return m_currentTerm;
 }
 
-void TermWidgetHolder::switchNextSubterminal()
+QList<TerminalWidget *> TermWidgetHolder::terminals() const
 {
-    // TODO/FIXME: merge switchPrevSubterminal with switchNextSubterminal
-    QList<TerminalWidget *> l = findChildren<TerminalWidget *>();
-    int ix = -1;
-    foreach (TerminalWidget *w, l) {
-        ++ix;
-        // qDebug() << ix << w << w << w->hasFocus() << QApplication::focusWidget();
-        // qDebug() << "parent: " << w->parent();
-        if (w->hasFocus())
-            break;
-    }
+    return m_terminals;
+}
 
-    if (ix < l.count()-1)
-        l.at(ix+1)->setFocus(Qt::OtherFocusReason);
-    else if (ix == l.count()-1)
-        l.at(0)->setFocus(Qt::OtherFocusReason);
+void TermWidgetHolder::switchNextSubterminal()
+{
+    if (TerminalWidget *terminal = adjacentTerminal(m_currentTerm, true))
+        terminal->setFocus(Qt::OtherFocusReason);
 }
 
 void TermWidgetHolder::switchPrevSubterminal()
 {
-    // TODO/FIXME: merge switchPrevSubterminal with switchNextSubterminal
-    QList<TerminalWidget *> l = findChildren<TerminalWidget *>();
-    int ix = -1;
-    foreach (TerminalWidget *w, l) {
-        ++ix;
-        // qDebug() << ix << w << w << w->hasFocus() << QApplication::focusWidget();
-        // qDebug() << "parent: " << w->parent();
-        if (w->hasFocus())
-            break;
-    }
-    // qDebug() << ix << l.at(ix) << QApplication::focusWidget() << l;
+    if (TerminalWidget *terminal = adjacentTerminal(m_currentTerm, false))
+        terminal->setFocus(Qt::OtherFocusReason);
+}
 
-    if (ix > 0)
-        l.at(ix-1)->setFocus(Qt::OtherFocusReason);
-    else if (ix == 0)
-        l.at(l.count()-1)->setFocus(Qt::OtherFocusReason);
+void TermWidgetHolder::focusTerminal(Direction direction)
+{
+    if (TerminalWidget *terminal = terminalInDirection(m_currentTerm, direction))
+        terminal->setFocus(Qt::OtherFocusReason);
 }
 
 void TermWidgetHolder::propertiesChanged()
 {
-    foreach (TerminalWidget *w, findChildren<TerminalWidget *>())
+    foreach (TerminalWidget *w, m_terminals)
         w->propertiesChanged();
 }
 
@@ -117,24 +126,28 @@ void TermWidgetHolder::splitVertical(TerminalWidget *term)
 
 void TermWidgetHolder::splitCollapse(TerminalWidget *term)
 {
-    QSplitter *parent = qobject_cast<QSplitter *>(term->parent());
+    TRACE_SCOPE("TermWidgetHolder::splitCollapse");
+
+    QSplitter *parent = parentSplitter(term);
     Q_ASSERT(parent);
+
+    // Focus moves to the neighbour that takes over the space
+    TerminalWidget *next = adjacentTerminal(term, parent->indexOf(term) == 0);
+    if (next == term)
+        next = nullptr;
+
+    m_terminals.removeOne(term);
+    if (m_currentTerm == term)
+        setCurrentTerminal(next);
     term->setParent(0);
     delete term;
 
-    int cnt = parent->findChildren<TerminalWidget *>().count();
-    if (cnt == 0) {
-        parent->setParent(0);
-        delete parent;
-    }
+    if (parent->count())
+        flatten(parent);
 
-    QList<TerminalWidget *> tlist = findChildren<TerminalWidget *>();
-    int localCnt = tlist.count();
-    if (localCnt > 0) {
-        tlist.at(0)->setFocus(Qt::OtherFocusReason);
+    if (next) {
+        next->setFocus(Qt::OtherFocusReason);
         update();
-        if (parent)
-            parent->update();
     } else {
         emit finished();
     }
@@ -142,18 +155,12 @@ void TermWidgetHolder::splitCollapse(TerminalWidget *term)
 
 void TermWidgetHolder::split(TerminalWidget *term, Qt::Orientation orientation)
 {
-    QSplitter *parent = qobject_cast<QSplitter *>(term->parent());
-    Q_ASSERT(parent);
-
-    int ix = parent->indexOf(term);
-    QList<int> parentSizes = parent->sizes();
+    TRACE_SCOPE("TermWidgetHolder::split");
 
-    QList<int> sizes;
-    sizes << 1 << 1;
+    QSplitter *parent = parentSplitter(term);
+    Q_ASSERT(parent);
 
-    QSplitter *s = new QSplitter(orientation, this);
-    s->setFocusPolicy(Qt::NoFocus);
-    s->insertWidget(0, term);
+    const int ix = parent->indexOf(term);
 
     // wdir settings
     QString wd(m_workingDir);
@@ -164,15 +171,245 @@ void TermWidgetHolder::split(TerminalWidget *term, Qt::Orientation orientation)
     }
 
     TerminalWidget *w = newTerm(wd);
-    s->insertWidget(1, w);
-    s->setSizes(sizes);
 
-    parent->insertWidget(ix, s);
-    parent->setSizes(parentSizes);
+    if (parent->count() == 1)
+        parent->setOrientation(orientation);
+
+    if (parent->orientation() == orientation) {
+        // The new terminal takes half of the space of the split one
+        QList<int> sizes = parent->sizes();
+        const int size = sizes.at(ix);
+        sizes[ix] = size - size / 2;
+        sizes.insert(ix + 1, size / 2);
+        parent->insertWidget(ix + 1, w);
+        parent->setSizes(sizes);
+    } else {
+        const QList<int> parentSizes = parent->sizes();
+
+        QSplitter *s = new QSplitter(orientation, this);
+        s->setFocusPolicy(Qt::NoFocus);
+        s->insertWidget(0, term);
+        s->insertWidget(1, w);
+        s->setSizes(QList<int>() << 1 << 1);
+
+        parent->insertWidget(ix, s);
+        parent->setSizes(parentSizes);
+    }
+
+    // Keep the list in layout order
+    m_terminals.insert(m_terminals.indexOf(term) + 1, w);
 
     w->setFocus(Qt::OtherFocusReason);
 }
 
+/*! Replaces \a term with a grid of \a rows by \a columns terminals.
+
+The layout is built with updates disabled and all shells are started once it
+is complete. \a term becomes the top left terminal of the grid.
+*/
+void TermWidgetHolder::createGrid(TerminalWidget *term, int rows, int columns)
+{
+    TRACE_SCOPE("TermWidgetHolder::createGrid");
+
+    if (rows < 1 || columns < 1 || rows * columns == 1)
+        return;
+
+    QSplitter *parent = parentSplitter(term);
+    Q_ASSERT(parent);
+
+    setUpdatesEnabled(false);
+    const bool startDeferred = TerminalWidget::isStartDeferred();
+    TerminalWidget::setStartDeferred(true);
+
+    const int ix = parent->indexOf(term);
+    const QList<int> parentSizes = parent->sizes();
+    int position = m_terminals.indexOf(term);
+
+    QSplitter *grid = new QSplitter(Qt::Vertical, this);
+    grid->setFocusPolicy(Qt::NoFocus);
+    for (int row = 0; row < rows; ++row) {
+        QSplitter *rowSplitter = new QSplitter(Qt::Horizontal, grid);
+        rowSplitter->setFocusPolicy(Qt::NoFocus);
+        for (int column = 0; column < columns; ++column) {
+            if (!row && !column) {
+                rowSplitter->addWidget(term);
+                continue;
+            }
+            TerminalWidget *w = newTerm();
+            rowSplitter->addWidget(w);
+            m_terminals.insert(++position, w);
+        }
+        rowSplitter->setSizes(QList<int>::fromVector(QVector<int>(columns, 1)));
+    }
+    grid->setSizes(QList<int>::fromVector(QVector<int>(rows, 1)));
+
+    parent->insertWidget(ix, grid);
+    parent->setSizes(parentSizes);
+
+    for (int row = grid->count() - 1; row >= 0; --row)
+        flatten(qobject_cast<QSplitter *>(grid->widget(row)));
+    flatten(grid);
+    // The grid may have become the only child of the root
+    flatten(m_rootSplitter);
+
+    if (!startDeferred)
+        TerminalWidget::setStartDeferred(false);
+    setUpdatesEnabled(true);
+
+    term->setFocus(Qt::OtherFocusReason);
+}
+
+/*! Keeps the layout tree flat.
+
+A splitter with a single child is replaced by the child, and a splitter with
+the orientation of its parent is merged into it. The root splitter stays, but
+takes over the children of a single child splitter.
+*/
+void TermWidgetHolder::flatten(QSplitter *splitter)
+{
+    if (splitter == m_rootSplitter) {
+        QSplitter *child = splitter->count() == 1
+                ? qobject_cast<QSplitter *>(splitter->widget(0)) : nullptr;
+        if (!child)
+            return;
+
+        const QList<int> sizes = child->sizes();
+        splitter->setOrientation(child->orientation());
+        while (child->count())
+            splitter->addWidget(child->widget(0));
+        child->setParent(0);
+        delete child;
+        splitter->setSizes(sizes);
+        return;
+    }
+
+    QSplitter *parent = parentSplitter(splitter);
+    const int count = splitter->count();
+    if (count != 1 && splitter->orientation() != parent->orientation())
+        return;
+
+    // The children share the space the splitter had
+    const int ix = parent->indexOf(splitter);
+    QList<int> parentSizes = parent->sizes();
+    const int size = parentSizes.takeAt(ix);
+    const QList<int> sizes = splitter->sizes();
+    int total = 0;
+    foreach (int childSize, sizes)
+        total += childSize;
+
+    for (int i = 0; i < count; ++i) {
+        parentSizes.insert(ix + i, total ? size * sizes.at(i) / total : size / count);
+        parent->insertWidget(ix + i, splitter->widget(0));
+    }
+
+    splitter->setParent(0);
+    delete splitter;
+    parent->setSizes(parentSizes);
+
+    // A single child may in turn have the orientation of the parent
+    if (count == 1) {
+        if (QSplitter *child = qobject_cast<QSplitter *>(parent->widget(ix)))
+            flatten(child);
+    }
+}
+
+QSize TermWidgetHolder::parseGridSize(const QString &text)
+{
+    const QStringList parts = text.split(QLatin1Char('x'));
+    if (parts.size() != 2)
+        return QSize();
+
+    bool rowsOk;
+    bool columnsOk;
+    const int rows = parts.at(0).trimmed().toInt(&rowsOk);
+    const int columns = parts.at(1).trimmed().toInt(&columnsOk);
+    if (!rowsOk || !columnsOk || rows < 1 || columns < 1 || rows * columns > MaxGridSize)
+        return QSize();
+    return QSize(columns, rows);
+}
+
+/*! Returns the terminal next to \a term in layout order, wrapping around.
+
+Walks up to the closest splitter with a sibling in that direction, then down
+to the nearest terminal of the sibling, so the cost depends on the depth of
+the layout tree only.
+*/
+TerminalWidget *TermWidgetHolder::adjacentTerminal(TerminalWidget *term, bool forward) const
+{
+    if (!term)
+        return m_terminals.isEmpty() ? nullptr : m_terminals.first();
+
+    QWidget *node = term;
+    while (node != m_rootSplitter) {
+        QSplitter *splitter = parentSplitter(node);
+        const int index = splitter->indexOf(node) + (forward ? 1 : -1);
+        if (index >= 0 && index < splitter->count())
+            return edgeTerminal(splitter->widget(index), forward);
+        node = splitter;
+    }
+
+    return edgeTerminal(m_rootSplitter, forward);
+}
+
+/*! Returns the terminal next to \a term on the given side, or nullptr at the edge.
+
+The closest splitter along the direction with a sibling on that side is found
+first. Inside the sibling, splitters along the direction are entered at the
+near end, and splitters across it at the child closest to the center of
+\a term.
+*/
+TerminalWidget *TermWidgetHolder::terminalInDirection(TerminalWidget *term,
+                                                      Direction direction) const
+{
+    if (!term)
+        return nullptr;
+
+    const Qt::Orientation orientation
+            = direction == Left || direction == Right ? Qt::Horizontal : Qt::Vertical;
+    const bool forward = direction == Right || direction == Down;
+
+    QWidget *node = term;
+    QWidget *neighbour = nullptr;
+    while (!neighbour && node != m_rootSplitter) {
+        QSplitter *splitter = parentSplitter(node);
+        if (splitter->orientation() == orientation) {
+            const int index = splitter->indexOf(node) + (forward ? 1 : -1);
+            if (index >= 0 && index < splitter->count())
+                neighbour = splitter->widget(index);
+        }
+        node = splitter;
+    }
+
+    const QPoint center = mappedGeometry(term).center();
+    while (QSplitter *splitter = qobject_cast<QSplitter *>(neighbour)) {
+        if (splitter->orientation() == orientation) {
+            neighbour = splitter->count() ? splitter->widget(forward ? 0 : splitter->count() - 1)
+                                          : nullptr;
+            continue;
+        }
+
+        neighbour = nullptr;
+        int closestDistance = INT_MAX;
+        for (int i = 0; i < splitter->count(); ++i) {
+            const QRect rect = mappedGeometry(splitter->widget(i));
+            const int distance = orientation == Qt::Horizontal
+                    ? qMax(0, qMax(rect.top() - center.y(), center.y() - rect.bottom()))
+                    : qMax(0, qMax(rect.left() - center.x(), center.x() - rect.right()));
+            if (distance < closestDistance) {
+                neighbour = splitter->widget(i);
+                closestDistance = distance;
+            }
+        }
+    }
+
+    return qobject_cast<TerminalWidget *>(neighbour);
+}
+
+QRect TermWidgetHolder::mappedGeometry(QWidget *widget) const
+{
+    return QRect(widget->mapTo(this, QPoint()), widget->size());
+}
+
 TerminalWidget *TermWidgetHolder::newTerm(const QString &wdir, const QString &shell)
 {
     QString wd(wdir);
@@ -183,7 +420,12 @@ TerminalWidget *TermWidgetHolder::newTerm(const QString &wdir, const QString &sh
     if (shell.isEmpty())
         sh = m_command;
 
-    TerminalWidget *w = new TerminalWidget(wd, sh, this);
+    TerminalWidget *w = nullptr;
+    if (sh.isEmpty())
+        w = ShellPool::instance()->take(wd, this);
+    if (!w)
+        w = new TerminalWidget(wd, sh, this);
+
     w->setContextMenuPolicy(Qt::CustomContextMenu);
     connect(w, &TerminalWidget::customContextMenuRequested,
             this, &TermWidgetHolder::terminalContextMenuRequested);
@@ -197,7 +439,15 @@ TerminalWidget *TermWidgetHolder::newTerm(const QString &wdir, const QString &sh
 
 void TermWidgetHolder::setCurrentTerminal(TerminalWidget *term)
 {
+    if (term == m_currentTerm)
+        return;
+
+    // The output of the current terminal is processed before that of the others
+    if (m_currentTerm)
+        m_currentTerm->setCurrent(false);
     m_currentTerm = term;
+    if (m_currentTerm)
+        m_currentTerm->setCurrent(true);
 }
 
 void TermWidgetHolder::handle_finished()
@@ -40,6 +40,13 @@ class TermWidgetHolder : public QWidget
     Q_OBJECT
 
 public:
+    enum Direction {
+        Left,
+        Right,
+        Up,
+        Down
+    };
+
     explicit TermWidgetHolder(const QString &wdir, const QString &shell = QString(),
                               QWidget *parent = nullptr);
 
@@ -47,6 +54,10 @@ public:
     void setInitialFocus();
 
     TerminalWidget *currentTerminal() const;
+    QList<TerminalWidget *> terminals() const;
+
+    void createGrid(TerminalWidget *term, int rows, int columns);
+    static QSize parseGridSize(const QString &text);
 
 public slots:
     void splitHorizontal(TerminalWidget *term);
@@ -54,6 +65,7 @@ public slots:
     void splitCollapse(TerminalWidget *term);
     void switchNextSubterminal();
     void switchPrevSubterminal();
+    void focusTerminal(Direction direction);
 
 signals:
     void terminalContextMenuRequested(const QPoint &pos);
@@ -64,7 +76,15 @@ private:
     QString m_command;
     TerminalWidget *m_currentTerm = nullptr;
 
+    // Layout tree: splitters are the nodes, terminals the leaves
+    QSplitter *m_rootSplitter = nullptr;
+    QList<TerminalWidget *> m_terminals; // in layout order
+
     void split(TerminalWidget *term, Qt::Orientation orientation);
+    void flatten(QSplitter *splitter);
+    TerminalWidget *adjacentTerminal(TerminalWidget *term, bool forward) const;
+    TerminalWidget *terminalInDirection(TerminalWidget *term, Direction direction) const;
+    QRect mappedGeometry(QWidget *widget) const;
     TerminalWidget *newTerm(const QString &wdir = QString(), const QString &shell = QString());
 
 private slots:
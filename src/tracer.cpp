@@ -0,0 +1,141 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+#include "tracer.h"
+
+#include <QFile>
+#include <QMutexLocker>
+#include <QThread>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+const int MaxEvents = 1024 * 1024; // 32 MiB
+
+qint64 currentThreadId()
+{
+#ifdef SYS_gettid
+    return syscall(SYS_gettid);
+#else
+    return reinterpret_cast<quintptr>(QThread::currentThreadId());
+#endif
+}
+}
+
+QAtomicInt Tracer::m_enabled;
+QElapsedTimer Tracer::m_clock;
+QMutex Tracer::m_mutex;
+QString Tracer::m_fileName;
+QVector<Tracer::Event> Tracer::m_events;
+int Tracer::m_next = 0;
+qint64 Tracer::m_dropped = 0;
+
+bool Tracer::isEnabled()
+{
+    return m_enabled.load();
+}
+
+bool Tracer::start(const QString &fileName)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_enabled.load())
+        return false;
+
+    m_fileName = fileName;
+    m_events.clear();
+    m_events.reserve(64 * 1024);
+    m_next = 0;
+    m_dropped = 0;
+    if (!m_clock.isValid())
+        m_clock.start();
+
+    m_enabled.store(1);
+    return true;
+}
+
+QString Tracer::stop()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_enabled.load())
+        return QString();
+    m_enabled.store(0);
+
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning("Cannot write trace to '%s': %s", qPrintable(m_fileName),
+                 qPrintable(file.errorString()));
+        m_events.clear();
+        return QString();
+    }
+
+    const qint64 pid = getpid();
+
+    QByteArray json("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (int i = 0; i < m_events.size(); ++i) {
+        const Event &event = m_events.at((m_next + i) % m_events.size());
+        if (i)
+            json.append(",\n");
+        // Timestamps are in microseconds
+        json.append("{\"name\":\"").append(event.name)
+                .append("\",\"cat\":\"quickterminal\",\"ph\":\"X\",\"ts\":")
+                .append(QByteArray::number(event.start / 1e3, 'f', 3))
+                .append(",\"dur\":").append(QByteArray::number(event.duration / 1e3, 'f', 3))
+                .append(",\"pid\":").append(QByteArray::number(pid))
+                .append(",\"tid\":").append(QByteArray::number(event.threadId))
+                .append('}');
+
+        if (json.size() > 1024 * 1024) {
+            file.write(json);
+            json.clear();
+        }
+    }
+    json.append("\n]}\n");
+    file.write(json);
+
+    if (m_dropped)
+        qWarning("Trace buffer was full, the oldest %lld spans were dropped", m_dropped);
+
+    m_events.clear();
+    m_events.squeeze();
+    return m_fileName;
+}
+
+qint64 Tracer::now()
+{
+    return m_clock.nsecsElapsed();
+}
+
+void Tracer::addSpan(const char *name, qint64 start, qint64 end)
+{
+    const Event event = {name, start, end - start, currentThreadId()};
+
+    QMutexLocker locker(&m_mutex);
+    if (!m_enabled.load())
+        return;
+
+    if (m_events.size() < MaxEvents) {
+        m_events.append(event);
+        return;
+    }
+
+    m_events[m_next] = event;
+    m_next = (m_next + 1) % MaxEvents;
+    ++m_dropped;
+}
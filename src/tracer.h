@@ -0,0 +1,88 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+/*! \brief Process-wide trace recorder.
+
+Spans are kept in memory while tracing is enabled and written as Chrome trace
+event JSON (which Perfetto and chrome://tracing can open) when it is stopped.
+The buffer is a ring, a long recording keeps only its most recent spans.
+When tracing is disabled a span costs a single atomic load.
+*/
+class Tracer
+{
+public:
+    static bool isEnabled();
+    static bool start(const QString &fileName);
+    static QString stop();
+
+    static qint64 now();
+    static void addSpan(const char *name, qint64 start, qint64 end);
+
+private:
+    struct Event {
+        const char *name;
+        qint64 start;
+        qint64 duration;
+        qint64 threadId;
+    };
+
+    static QAtomicInt m_enabled;
+    static QElapsedTimer m_clock;
+    static QMutex m_mutex;
+    static QString m_fileName;
+    static QVector<Event> m_events;
+    static int m_next; // oldest event once the ring is full
+    static qint64 m_dropped;
+};
+
+/// Records a span from its construction to the end of the enclosing scope
+class TraceScope
+{
+public:
+    explicit TraceScope(const char *name) :
+        m_name(name),
+        m_start(Tracer::isEnabled() ? Tracer::now() : -1)
+    {
+    }
+
+    ~TraceScope()
+    {
+        if (m_start >= 0)
+            Tracer::addSpan(m_name, m_start, Tracer::now());
+    }
+
+private:
+    Q_DISABLE_COPY(TraceScope)
+
+    const char * const m_name;
+    const qint64 m_start;
+};
+
+#define TRACE_SCOPE(name) TraceScope traceScope(name)
+
+#endif // TRACER_H
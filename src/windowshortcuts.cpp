@@ -0,0 +1,70 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#include "windowshortcuts.h"
+
+#include "actionmanager.h"
+#include "constants.h"
+#include "mainwindow.h"
+
+#include <QAction>
+#include <QApplication>
+
+WindowShortcuts *WindowShortcuts::m_instance = nullptr;
+
+/// Must not be used before the actions are registered
+WindowShortcuts *WindowShortcuts::instance()
+{
+    if (!m_instance)
+        m_instance = new WindowShortcuts(qApp);
+    return m_instance;
+}
+
+WindowShortcuts::WindowShortcuts(QObject *parent) :
+    QObject(parent),
+    m_actionManager(new ActionManager())
+{
+    // Shortcuts changed later are updated by the action manager
+    foreach (const ActionInfo &actionInfo, ActionManager::registry()) {
+        const QString id = actionInfo.id;
+        if (!MainWindow::handlesAction(id))
+            continue;
+
+        QAction *action = m_actionManager->action(id);
+        connect(action, &QAction::triggered, this, [id]() {
+            MainWindow *window = qobject_cast<MainWindow *>(QApplication::activeWindow());
+            if (window)
+                window->triggerAction(id);
+        });
+        m_actions.append(action);
+    }
+}
+
+WindowShortcuts::~WindowShortcuts()
+{
+    delete m_actionManager;
+    m_instance = nullptr;
+}
+
+/// Makes the shortcuts work in \a window, windows do not have to be detached
+void WindowShortcuts::attach(QWidget *window)
+{
+    window->addActions(m_actions);
+}
@@ -0,0 +1,57 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Oleg Shparber <trollixx+quickterminal@gmail.com>
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License as
+** published by the Free Software Foundation; either version 2 of
+** the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**
+****************************************************************************/
+
+
+#ifndef WINDOWSHORTCUTS_H
+#define WINDOWSHORTCUTS_H
+
+#include <QList>
+#include <QObject>
+
+class QAction;
+class QWidget;
+
+class ActionManager;
+
+/*! \brief Keyboard shortcuts shared by all main windows.
+
+One QAction is created per registered window action for the whole
+application and added to every window, a triggered shortcut is handed to the
+active window. Opening a window therefore creates no actions of its own, they
+are only created when one of its menus is opened or a shortcut is used.
+*/
+class WindowShortcuts : public QObject
+{
+public:
+    static WindowShortcuts *instance();
+
+    void attach(QWidget *window);
+
+private:
+    static WindowShortcuts *m_instance;
+
+    explicit WindowShortcuts(QObject *parent = nullptr);
+    Q_DISABLE_COPY(WindowShortcuts)
+    ~WindowShortcuts() override;
+
+    ActionManager *m_actionManager = nullptr;
+    QList<QAction *> m_actions;
+};
+
+#endif // WINDOWSHORTCUTS_H